@@ -0,0 +1,132 @@
+#include "agrupacion.h"
+#include "tablahashinline.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#define TAM_LOTE 16
+
+/**
+ * Estructura principal que representa la agrupacion.
+ * Cada dato de la tabla mide tamDato bytes: la clave y, desde desplazamiento
+ * (la clave redondeada para alinear), su Acumulador. nuevo es un dato armado
+ * con acumuladores vacios, en el que se copia la clave antes de buscarla.
+ */
+struct _Agrupacion {
+  TablaHashInline tabla;
+  size_t tamClave;
+  size_t desplazamiento;
+  FuncionHash hash;
+  char *nuevo;
+};
+
+/**
+ * Retorna los acumuladores de un dato de la tabla.
+ */
+static Acumulador *agrupacion_acumulador(Agrupacion agrupacion, void *dato) {
+  return (Acumulador *)((char *)dato + agrupacion->desplazamiento);
+}
+
+/**
+ * Crea una agrupacion vacia.
+ */
+Agrupacion agrupacion_crear(unsigned capacidad, size_t tamClave,
+                            FuncionComparadora comp, FuncionHash hash) {
+  Agrupacion agrupacion = malloc(sizeof(struct _Agrupacion));
+  assert(agrupacion != NULL);
+  agrupacion->tamClave = tamClave;
+  agrupacion->desplazamiento = (tamClave + _Alignof(Acumulador) - 1) /
+                               _Alignof(Acumulador) * _Alignof(Acumulador);
+  agrupacion->hash = hash;
+  size_t tamDato = agrupacion->desplazamiento + sizeof(Acumulador);
+  agrupacion->tabla = tablahashinline_crear(capacidad, tamDato, tamClave, comp, hash);
+
+  agrupacion->nuevo = calloc(1, tamDato);
+  assert(agrupacion->nuevo != NULL);
+  Acumulador *vacio = agrupacion_acumulador(agrupacion, agrupacion->nuevo);
+  vacio->cantidad = 0;
+  vacio->suma = 0;
+  vacio->minimo = INFINITY;
+  vacio->maximo = -INFINITY;
+  return agrupacion;
+}
+
+/**
+ * Destruye la agrupacion.
+ */
+void agrupacion_destruir(Agrupacion agrupacion) {
+  tablahashinline_destruir(agrupacion->tabla);
+  free(agrupacion->nuevo);
+  free(agrupacion);
+}
+
+/**
+ * Retorna el numero de grupos.
+ */
+int agrupacion_ngrupos(Agrupacion agrupacion) {
+  return tablahashinline_nelems(agrupacion->tabla);
+}
+
+/**
+ * Acumula n filas, de a lotes de TAM_LOTE. Cada fila actualiza su grupo
+ * apenas lo encuentra, mientras la casilla sigue en cache (ver agrupacion.h).
+ */
+void agrupacion_acumular(Agrupacion agrupacion, const void *claves,
+                         const double *valores, size_t n) {
+  const char *clave = claves;
+  unsigned hashes[TAM_LOTE];
+  for (size_t inicio = 0; inicio < n; inicio += TAM_LOTE) {
+    size_t lote = (n - inicio < TAM_LOTE) ? n - inicio : TAM_LOTE;
+    for (size_t i = 0; i < lote; i++) {
+      hashes[i] = agrupacion->hash((void *)(clave + i * agrupacion->tamClave));
+      tablahashinline_adelantar(agrupacion->tabla, hashes[i]);
+    }
+    for (size_t i = 0; i < lote; i++, clave += agrupacion->tamClave) {
+      memcpy(agrupacion->nuevo, clave, agrupacion->tamClave);
+      Acumulador *acumulador = agrupacion_acumulador(
+          agrupacion, tablahashinline_buscar_o_insertar_hash(
+                          agrupacion->tabla, agrupacion->nuevo, hashes[i], NULL));
+      acumulador->cantidad++;
+      if (valores != NULL) {
+        double valor = valores[inicio + i];
+        acumulador->suma += valor;
+        if (valor < acumulador->minimo)
+          acumulador->minimo = valor;
+        if (valor > acumulador->maximo)
+          acumulador->maximo = valor;
+      }
+    }
+  }
+}
+
+/**
+ * Retorna los acumuladores del grupo con la clave dada, o NULL.
+ */
+const Acumulador *agrupacion_buscar(Agrupacion agrupacion, const void *clave) {
+  void *dato = tablahashinline_buscar(agrupacion->tabla, clave);
+  return (dato != NULL) ? agrupacion_acumulador(agrupacion, dato) : NULL;
+}
+
+/**
+ * Datos que necesita agrupacion_visitar para llamar a la funcion del usuario.
+ */
+typedef struct {
+  Agrupacion agrupacion;
+  FuncionVisitanteGrupo visita;
+  void *extra;
+} Recorrido;
+
+static void agrupacion_visitar(void *dato, void *extra) {
+  Recorrido *recorrido = extra;
+  recorrido->visita(dato, agrupacion_acumulador(recorrido->agrupacion, dato),
+                    recorrido->extra);
+}
+
+/**
+ * Aplica visita a cada grupo.
+ */
+void agrupacion_recorrer(Agrupacion agrupacion, FuncionVisitanteGrupo visita,
+                         void *extra) {
+  Recorrido recorrido = {agrupacion, visita, extra};
+  tablahashinline_recorrer(agrupacion->tabla, agrupacion_visitar, &recorrido);
+}
@@ -0,0 +1,71 @@
+#ifndef __AGRUPACION_H__
+#define __AGRUPACION_H__
+
+#include "tablahash.h"
+#include <stddef.h>
+
+/**
+ * Agrupacion por clave (GROUP BY) con acumuladores de cantidad, suma, minimo
+ * y maximo. Los grupos se guardan en una TablaHashInline: cada dato es la
+ * clave seguida de su Acumulador, asi que actualizar un grupo no sigue ningun
+ * puntero. Las filas se acumulan por columnas y de a lotes: primero se
+ * calculan los hashes del lote y se adelanta la carga de sus casillas, y
+ * despues cada fila busca o inserta su grupo con un solo calculo del hash.
+ * La actualizacion de los acumuladores es escalar, fila por fila: dos filas
+ * del lote pueden ser del mismo grupo, y escribir los acumuladores de todo el
+ * lote con instrucciones vectoriales perderia las actualizaciones repetidas.
+ * Ademas casi todo el tiempo de una fila se va en el hash y la busqueda del
+ * grupo, no en los acumuladores.
+ */
+typedef struct _Agrupacion *Agrupacion;
+
+typedef struct {
+  unsigned long cantidad;
+  double suma;
+  double minimo;
+  double maximo;
+} Acumulador;
+
+typedef void (*FuncionVisitanteGrupo)(const void *clave,
+                                      const Acumulador *acumulador, void *extra);
+/** Recibe la clave y los acumuladores de cada grupo junto con un puntero extra */
+
+/**
+ * Crea una agrupacion vacia, con lugar inicial para capacidad grupos, de
+ * claves de tamClave bytes. La funcion hash recibe un puntero a la clave. Si
+ * comp es NULL, las claves se comparan con memcmp.
+ */
+Agrupacion agrupacion_crear(unsigned capacidad, size_t tamClave,
+                            FuncionComparadora comp, FuncionHash hash);
+
+/**
+ * Destruye la agrupacion.
+ */
+void agrupacion_destruir(Agrupacion agrupacion);
+
+/**
+ * Retorna el numero de grupos.
+ */
+int agrupacion_ngrupos(Agrupacion agrupacion);
+
+/**
+ * Acumula n filas: la clave de la fila i ocupa los tamClave bytes a partir de
+ * claves + i * tamClave, y su valor es valores[i]. Si valores es NULL solo se
+ * cuentan las filas.
+ */
+void agrupacion_acumular(Agrupacion agrupacion, const void *claves,
+                         const double *valores, size_t n);
+
+/**
+ * Retorna los acumuladores del grupo con la clave dada, o NULL si no hay
+ * ninguna fila con esa clave. El puntero deja de ser valido al acumular.
+ */
+const Acumulador *agrupacion_buscar(Agrupacion agrupacion, const void *clave);
+
+/**
+ * Aplica visita a cada grupo, en un orden no especificado.
+ */
+void agrupacion_recorrer(Agrupacion agrupacion, FuncionVisitanteGrupo visita,
+                         void *extra);
+
+#endif /* __AGRUPACION_H__ */
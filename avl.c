@@ -1,7 +1,161 @@
+#define _POSIX_C_SOURCE 200809L
 #include "avl.h"
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#define NODOS_POR_BLOQUE 4096
+/**
+ * Las operaciones de conjuntos reparten en otro hilo solo los subproblemas de
+ * al menos CORTE_PARALELO datos; los mas chicos se resuelven en el mismo hilo.
+ */
+#define CORTE_PARALELO 8192
+/**
+ * Cota de la altura de un arbol AVL (1.44 log2(n) para n nodos), que acota el
+ * largo de los caminos que guardan las operaciones iterativas.
+ */
+#define ALTURA_MAXIMA 64
+
+/**
+ * Bloque de la arena: nodos contiguos, encadenados con los demas bloques.
+ */
+typedef struct _AVL_Bloque {
+  struct _AVL_Bloque* sig;
+  AVL_Nodo nodos[];
+} AVL_Bloque;
+
+/**
+ * Estructura de la arena.
+ * Los nodos se reparten del bloque mas nuevo (bloques), del que ya se usaron
+ * usados de nodosPorBloque. Los nodos devueltos forman la lista libres,
+ * encadenados por izq, y se reparten antes que los del bloque. referencias es
+ * la cantidad de arboles que toman nodos de la arena (mas de uno despues de
+ * avl_split); la arena se libera con el ultimo de ellos.
+ */
+struct _AVL_Arena {
+  AVL_Bloque* bloques;
+  unsigned usados;
+  unsigned nodosPorBloque;
+  AVL_Nodo* libres;
+  unsigned referencias;
+};
+
+/**
+ * avl_arena_crear: Funcion interna que retorna una arena sin bloques.
+ */
+static AVL_Arena* avl_arena_crear(unsigned nodosPorBloque){
+  AVL_Arena* arena = malloc(sizeof(AVL_Arena));
+  assert(arena);
+  arena->bloques = NULL;
+  arena->nodosPorBloque = (nodosPorBloque > 0) ? nodosPorBloque : NODOS_POR_BLOQUE;
+  arena->usados = arena->nodosPorBloque;
+  arena->libres = NULL;
+  arena->referencias = 1;
+  return arena;
+}
+
+/**
+ * avl_arena_tomar: Funcion interna que retorna un nodo de la arena, alocando
+ * un bloque nuevo si no quedan nodos libres.
+ */
+static AVL_Nodo* avl_arena_tomar(AVL_Arena* arena){
+  if (arena->libres != NULL)
+  {
+    AVL_Nodo* nodo = arena->libres;
+    arena->libres = nodo->izq;
+    return nodo;
+  }
+  if (arena->usados == arena->nodosPorBloque)
+  {
+    AVL_Bloque* bloque = malloc(sizeof(AVL_Bloque) +
+                                sizeof(AVL_Nodo) * arena->nodosPorBloque);
+    assert(bloque);
+    bloque->sig = arena->bloques;
+    arena->bloques = bloque;
+    arena->usados = 0;
+  }
+  return &arena->bloques->nodos[arena->usados++];
+}
+
+/**
+ * avl_arena_destruir: Funcion interna que libera todos los bloques de la
+ * arena, y con ellos todos sus nodos.
+ */
+static void avl_arena_destruir(AVL_Arena* arena){
+  while (arena->bloques != NULL)
+  {
+    AVL_Bloque* sig = arena->bloques->sig;
+    free(arena->bloques);
+    arena->bloques = sig;
+  }
+  free(arena);
+}
+
+/**
+ * avl_arena_absorber: Funcion interna que pasa a la arena los bloques y los
+ * nodos libres de otra, y libera la otra. Los nodos que quedaban sin usar en
+ * el bloque mas nuevo de la otra pasan a la lista libre.
+ */
+static void avl_arena_absorber(AVL_Arena* arena, AVL_Arena* otra){
+  for (; otra->usados < otra->nodosPorBloque; otra->usados++)
+  {
+    AVL_Nodo* nodo = &otra->bloques->nodos[otra->usados];
+    nodo->izq = otra->libres;
+    otra->libres = nodo;
+  }
+  // Los bloques de la otra van despues del mas nuevo de la arena, que es del
+  // que se siguen repartiendo nodos.
+  if (otra->bloques != NULL)
+  {
+    AVL_Bloque* ultimo = otra->bloques;
+    while (ultimo->sig != NULL)
+      ultimo = ultimo->sig;
+    if (arena->bloques != NULL)
+    {
+      ultimo->sig = arena->bloques->sig;
+      arena->bloques->sig = otra->bloques;
+    }
+    else
+      arena->bloques = otra->bloques;
+  }
+  if (otra->libres != NULL)
+  {
+    AVL_Nodo* ultimo = otra->libres;
+    while (ultimo->izq != NULL)
+      ultimo = ultimo->izq;
+    ultimo->izq = arena->libres;
+    arena->libres = otra->libres;
+  }
+  free(otra);
+}
+
+/**
+ * avl_nodo_alocar: Funcion interna que retorna un nodo sin inicializar, de la
+ * arena si la hay.
+ */
+static AVL_Nodo* avl_nodo_alocar(AVL_Arena* arena){
+  if (arena != NULL)
+    return avl_arena_tomar(arena);
+  AVL_Nodo* nodo = malloc(sizeof(AVL_Nodo));
+  assert(nodo);
+  return nodo;
+}
+
+/**
+ * avl_nodo_liberar: Funcion interna que libera el nodo (no su dato),
+ * devolviendolo a la arena si la hay.
+ */
+static void avl_nodo_liberar(AVL_Nodo* nodo, AVL_Arena* arena){
+  if (arena != NULL)
+  {
+    nodo->izq = arena->libres;
+    arena->libres = nodo;
+  }
+  else
+    free(nodo);
+}
 
 /**
  * Retorna un arbol AVL vacio
@@ -13,42 +167,66 @@ AVL avl_crear(FuncionCopiadora copia, FuncionComparadora comp, FuncionDestructor
   arbol->copia = copia;
   arbol->destr = destr;
   arbol->raiz = NULL;
+  arbol->arena = NULL;
+  return arbol;
+}
+
+/**
+ * Retorna un arbol AVL vacio cuyos nodos se toman de una arena
+ */
+AVL avl_crear_con_arena(FuncionCopiadora copia, FuncionComparadora comp,
+                        FuncionDestructora destr, unsigned nodosPorBloque){
+  AVL arbol = avl_crear(copia, comp, destr);
+  arbol->arena = avl_arena_crear(nodosPorBloque);
   return arbol;
 }
 
 /**
  * Destruye el arbol y sus datos.
+ * Con una arena que solo usa este arbol, los nodos se liberan junto con sus
+ * bloques, asi que solo se recorren si hay que destruir los datos. Si otro
+ * arbol comparte la arena, los nodos vuelven a su lista libre.
  */
-static void avl_nodo_destruir(AVL_Nodo* raiz, FuncionDestructora destr){
+static void avl_nodo_destruir(AVL_Nodo* raiz, FuncionDestructora destr, AVL_Arena* arena){
   if (raiz != NULL)
   {
-    avl_nodo_destruir(raiz->izq, destr);
-    avl_nodo_destruir(raiz->der, destr);
-    destr(raiz->dato);
-    free(raiz);
+    avl_nodo_destruir(raiz->izq, destr, arena);
+    avl_nodo_destruir(raiz->der, destr, arena);
+    if (destr != NULL)
+      destr(raiz->dato);
+    avl_nodo_liberar(raiz, arena);
   }
   
 }
 void avl_destruir(AVL arbol){
-  avl_nodo_destruir(arbol->raiz,arbol->destr);
+  AVL_Arena* arena = arbol->arena;
+  if (arena == NULL || arbol->destr != NULL || arena->referencias > 1)
+    avl_nodo_destruir(arbol->raiz, arbol->destr, arena);
+  if (arena != NULL && --arena->referencias == 0)
+    avl_arena_destruir(arena);
   free(arbol);
 }
 
 /**
- * Retorna 1 si el dato se encuentra y 0 en caso contrario
+ * avl_nodo_ubicar: Funcion interna que retorna el nodo con el dato, o NULL si
+ * no se encuentra. Compara una sola vez por nodo visitado.
  */
-static int avl_nodo_buscar(AVL_Nodo* raiz, FuncionComparadora comp, void* dato){
-  if (raiz == NULL)
-    return 0;
-  else if (comp(raiz->dato, dato) == 0)
-    return 1;
-  else if (comp(raiz->dato, dato) > 0)
-    return avl_nodo_buscar(raiz->izq, comp, dato);
-  else
-    return avl_nodo_buscar(raiz->der, comp, dato);
+static AVL_Nodo* avl_nodo_ubicar(AVL_Nodo* raiz, FuncionComparadora comp, void* dato){
+  while (raiz != NULL)
+  {
+    int c = comp(raiz->dato, dato);
+    if (c == 0)
+      return raiz;
+    raiz = (c > 0) ? raiz->izq : raiz->der;
+  }
+  return NULL;
 }
+
+/**
+ * Retorna 1 si el dato se encuentra y 0 en caso contrario
+ */
 int avl_buscar(AVL arbol, void * dato){
-  return avl_nodo_buscar(arbol->raiz, arbol->comp, dato);
+  return avl_nodo_ubicar(arbol->raiz, arbol->comp, dato) != NULL;
 }
 
 /**
@@ -59,6 +237,21 @@ static int avl_nodo_altura(AVL_Nodo* raiz) {
   return (raiz == NULL) ? -1 : raiz->altura;
 }
 
+/**
+ * avl_nodo_tamano: Funcion interna que retorna el numero de nodos del arbol.
+ */
+static int avl_nodo_tamano(AVL_Nodo* raiz) {
+  return (raiz == NULL) ? 0 : raiz->tamano;
+}
+
+/**
+ * avl_nodo_actualizar_tamano: Funcion interna que recalcula el numero de nodos
+ * del arbol a partir de los de sus hijos.
+ */
+static void avl_nodo_actualizar_tamano(AVL_Nodo* raiz) {
+  raiz->tamano = 1 + avl_nodo_tamano(raiz->izq) + avl_nodo_tamano(raiz->der);
+}
+
 /**
  * avl_nodo_max_altura_hijos: Funcion interna que retorna la maxima altura de
  * los hijos.
@@ -94,6 +287,8 @@ static AVL_Nodo* avl_nodo_rotacion_simple_izq(AVL_Nodo* raiz) {
 
   raiz->altura = 1 + avl_nodo_max_altura_hijos(raiz);
   hijoder->altura = 1 + avl_nodo_max_altura_hijos(hijoder);
+  avl_nodo_actualizar_tamano(raiz);
+  avl_nodo_actualizar_tamano(hijoder);
   return hijoder; 
 }
 
@@ -110,6 +305,8 @@ static AVL_Nodo* avl_nodo_rotacion_simple_der(AVL_Nodo* raiz) {
 
   raiz->altura = 1 + avl_nodo_max_altura_hijos(raiz);
   hijoizq->altura = 1 + avl_nodo_max_altura_hijos(hijoizq);
+  avl_nodo_actualizar_tamano(raiz);
+  avl_nodo_actualizar_tamano(hijoizq);
   return hijoizq;
 }
 /**
@@ -131,39 +328,170 @@ static AVL_Nodo* avl_balancear_arbol(AVL_Nodo* raiz){
   }
   return raiz;
 }
-void avl_balancear(AVL arbol){
-  arbol->raiz = avl_balancear_arbol(arbol->raiz);
+AVL avl_balancear(AVL arbol){
+  if (arbol->raiz != NULL)
+    arbol->raiz = avl_balancear_arbol(arbol->raiz);
+  return arbol;
+}
+
+/**
+ * avl_nodo_rebalancear_camino: Funcion interna que, despues de insertar o
+ * eliminar un nodo, actualiza las alturas y los tamanos y balancea los nodos
+ * del camino desde el fondo hacia la raiz. camino tiene los enlaces (la raiz
+ * del arbol o un hijo del nodo anterior) de los tope nodos recorridos. Si un
+ * subarbol termina con la misma altura que antes, los de mas arriba no
+ * necesitan balancearse y solo se les actualiza el tamano.
+ */
+static void avl_nodo_rebalancear_camino(AVL_Nodo** camino[], int tope){
+  int i = tope - 1;
+  for (; i >= 0; i--)
+  {
+    AVL_Nodo* nodo = *camino[i];
+    int alturaVieja = nodo->altura;
+    nodo->altura = 1 + avl_nodo_max_altura_hijos(nodo);
+    avl_nodo_actualizar_tamano(nodo);
+    nodo = *camino[i] = avl_balancear_arbol(nodo);
+    if (nodo->altura == alturaVieja)
+      break;
+  }
+  for (i--; i >= 0; i--)
+    avl_nodo_actualizar_tamano(*camino[i]);
 }
 
 /**
  * Inserta un dato no repetido en el arbol, manteniendo la propiedad de los
  * arboles AVL.
  */
-static AVL_Nodo* avl_nodo_crear(void* dato, FuncionCopiadora copy){
-  AVL_Nodo* nuevo_nodo = malloc(sizeof(AVL_Nodo));
-  assert(nuevo_nodo);
+static AVL_Nodo* avl_nodo_crear(void* dato, FuncionCopiadora copy, AVL_Arena* arena){
+  AVL_Nodo* nuevo_nodo = avl_nodo_alocar(arena);
   nuevo_nodo->dato = copy(dato);
   nuevo_nodo->altura = 0;
+  nuevo_nodo->tamano = 1;
   nuevo_nodo->der = nuevo_nodo->izq =  NULL;
   return nuevo_nodo;
 }
-static AVL_Nodo* avl_nodo_insertar(AVL_Nodo* raiz, void* dato, 
-  FuncionComparadora comp, FuncionCopiadora copy){
-    if (raiz == NULL)
-      return avl_nodo_crear(dato, copy);
-    else if (comp(raiz->dato,dato) > 0)
-      raiz->izq = avl_nodo_insertar(raiz->izq, dato, comp, copy);
-    else if (comp(raiz->dato, dato) < 0)
-      raiz->der = avl_nodo_insertar(raiz->der, dato, comp, copy);
-    else
-      return raiz;
-    
-    raiz->altura = 1 + avl_nodo_max_altura_hijos(raiz);
-    
-    return avl_balancear_arbol(raiz);
-}
 void avl_insertar(AVL arbol, void *dato){
-  arbol->raiz = avl_nodo_insertar(arbol->raiz, dato, arbol->comp, arbol->copia);
+  AVL_Nodo** camino[ALTURA_MAXIMA];
+  int tope = 0;
+  AVL_Nodo** enlace = &arbol->raiz;
+  while (*enlace != NULL)
+  {
+    int c = arbol->comp((*enlace)->dato, dato);
+    if (c == 0)
+      return;
+    assert(tope < ALTURA_MAXIMA);
+    camino[tope++] = enlace;
+    enlace = (c > 0) ? &(*enlace)->izq : &(*enlace)->der;
+  }
+  *enlace = avl_nodo_crear(dato, arbol->copia, arbol->arena);
+  avl_nodo_rebalancear_camino(camino, tope);
+}
+
+/**
+ * avl_intercalar: Funcion interna que intercala los arreglos ordenados
+ * izq[0..nIzq) y der[0..nDer) en destino. Ante datos iguales va primero el de
+ * izq, asi que el orden es estable.
+ */
+static void avl_intercalar(void** izq, size_t nIzq, void** der, size_t nDer,
+  void** destino, FuncionComparadora comp){
+  size_t i = 0, j = 0, k = 0;
+  while (i < nIzq && j < nDer)
+    destino[k++] = (comp(izq[i], der[j]) <= 0) ? izq[i++] : der[j++];
+  while (i < nIzq)
+    destino[k++] = izq[i++];
+  while (j < nDer)
+    destino[k++] = der[j++];
+}
+
+/**
+ * avl_ordenar: Funcion interna que ordena los n punteros de datos por merge
+ * sort de abajo hacia arriba, usando aux (tambien de n posiciones) como
+ * arreglo auxiliar. Retorna el arreglo que quedo ordenado (datos o aux).
+ */
+static void** avl_ordenar(void** datos, void** aux, size_t n, FuncionComparadora comp){
+  for (size_t ancho = 1; ancho < n; ancho *= 2)
+  {
+    for (size_t i = 0; i < n; i += 2 * ancho)
+    {
+      size_t nIzq = (n - i < ancho) ? n - i : ancho;
+      size_t nDer = (n - i - nIzq < ancho) ? n - i - nIzq : ancho;
+      avl_intercalar(datos + i, nIzq, datos + i + nIzq, nDer, aux + i, comp);
+    }
+    void** temp = datos;
+    datos = aux;
+    aux = temp;
+  }
+  return datos;
+}
+
+/**
+ * avl_sin_repetidos: Funcion interna que copia los n datos a destino sin
+ * repetidos consecutivos y retorna cuantos copio, o n + 1 si encuentra dos
+ * datos fuera de orden.
+ */
+static size_t avl_sin_repetidos(void** datos, size_t n, void** destino,
+  FuncionComparadora comp){
+  size_t m = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    int c = (m > 0) ? comp(destino[m - 1], datos[i]) : -1;
+    if (c > 0)
+      return n + 1;
+    if (c < 0)
+      destino[m++] = datos[i];
+  }
+  return m;
+}
+
+/**
+ * avl_nodo_construir: Funcion interna que construye un arbol perfectamente
+ * balanceado con los n datos ordenados. Los nodos se crean en inorden, asi
+ * que con una arena quedan contiguos en ese orden.
+ */
+static AVL_Nodo* avl_nodo_construir(void** datos, size_t n, FuncionCopiadora copy,
+  AVL_Arena* arena){
+  if (n == 0)
+    return NULL;
+  size_t medio = n / 2;
+  AVL_Nodo* izq = avl_nodo_construir(datos, medio, copy, arena);
+  AVL_Nodo* raiz = avl_nodo_crear(datos[medio], copy, arena);
+  raiz->izq = izq;
+  raiz->der = avl_nodo_construir(datos + medio + 1, n - medio - 1, copy, arena);
+  raiz->altura = 1 + avl_nodo_max_altura_hijos(raiz);
+  avl_nodo_actualizar_tamano(raiz);
+  return raiz;
+}
+
+/**
+ * Retorna un arbol AVL con los n datos del arreglo
+ */
+AVL avl_crear_desde_arreglo(void** datos, size_t n, FuncionCopiadora copia,
+  FuncionComparadora comp, FuncionDestructora destr){
+  void** orden = malloc(sizeof(void*) * (n + 1));
+  assert(orden);
+  size_t m = avl_sin_repetidos(datos, n, orden, comp);
+  if (m > n)
+  {
+    void** aux = malloc(sizeof(void*) * (n + 1));
+    assert(aux);
+    void** ordenados = avl_ordenar(memcpy(aux, datos, sizeof(void*) * n), orden, n, comp);
+    m = avl_sin_repetidos(ordenados, n, (ordenados == orden) ? aux : orden, comp);
+    if (ordenados == orden)
+    {
+      free(orden);
+      orden = aux;
+    }
+    else
+      free(aux);
+  }
+
+  // El primer bloque de la arena tiene justo los m nodos; los que se inserten
+  // despues van en bloques del tamano predeterminado.
+  AVL arbol = avl_crear_con_arena(copia, comp, destr, (unsigned)m);
+  arbol->raiz = avl_nodo_construir(orden, m, copia, arbol->arena);
+  arbol->arena->usados = arbol->arena->nodosPorBloque = NODOS_POR_BLOQUE;
+  free(orden);
+  return arbol;
 }
 
 /**
@@ -191,8 +519,9 @@ static int avl_validar_altura_balance(AVL_Nodo* raiz){
 
   int altura = 1 + avl_nodo_max_altura_hijos(raiz);
   int factor = avl_nodo_factor_balance(raiz);
+  int tamano = 1 + avl_nodo_tamano(raiz->izq) + avl_nodo_tamano(raiz->der);
 
-  if (altura == raiz->altura && factor >= -1 && factor <= 1)
+  if (altura == raiz->altura && tamano == raiz->tamano && factor >= -1 && factor <= 1)
     return 1;
   return 0;
 }
@@ -224,56 +553,667 @@ void avl_recorrer(AVL arbol, AVLRecorrido orden, FuncionVisitanteExtra visita, v
 /**
  * avl_eliminar: Elimina el dato indicado en el avl, manteniendo la condicion de AVL
  */
-static AVL_Nodo* avl_min(AVL_Nodo* raiz){
-  if (raiz->izq == NULL)
-    return raiz;
-  return avl_min(raiz->izq);
+AVL avl_eliminar(AVL arbol, void* dato){
+  AVL_Nodo** camino[ALTURA_MAXIMA];
+  int tope = 0;
+  AVL_Nodo** enlace = &arbol->raiz;
+  while (*enlace != NULL)
+  {
+    int c = arbol->comp((*enlace)->dato, dato);
+    if (c == 0)
+      break;
+    assert(tope < ALTURA_MAXIMA);
+    camino[tope++] = enlace;
+    enlace = (c > 0) ? &(*enlace)->izq : &(*enlace)->der;
+  }
+  if (*enlace == NULL)
+    return arbol;
+
+  AVL_Nodo* nodo = *enlace;
+  if (nodo->izq != NULL && nodo->der != NULL)
+  {
+    // El nodo se queda con el dato de su sucesor, y se quita el nodo del
+    // sucesor, que no tiene hijo izquierdo.
+    assert(tope < ALTURA_MAXIMA);
+    camino[tope++] = enlace;
+    enlace = &nodo->der;
+    while ((*enlace)->izq != NULL)
+    {
+      assert(tope < ALTURA_MAXIMA);
+      camino[tope++] = enlace;
+      enlace = &(*enlace)->izq;
+    }
+    AVL_Nodo* sucesor = *enlace;
+    void* dato_temp = nodo->dato;
+    nodo->dato = sucesor->dato;
+    sucesor->dato = dato_temp;
+    nodo = sucesor;
+  }
+  *enlace = (nodo->izq != NULL) ? nodo->izq : nodo->der;
+  if (arbol->destr != NULL)
+    arbol->destr(nodo->dato);
+  avl_nodo_liberar(nodo, arbol->arena);
+  avl_nodo_rebalancear_camino(camino, tope);
+  return arbol;
+}
+
+/**
+ * avl_obtener_dato: retorna el puntero del dato que se busca
+ */
+void* avl_obtener(AVL arbol, void * dato){
+  AVL_Nodo* nodo = avl_nodo_ubicar(arbol->raiz, arbol->comp, dato);
+  return (nodo != NULL) ? nodo->dato : NULL;
+}
+
+/**
+ * Retorna el numero de datos del arbol.
+ */
+int avl_nelems(AVL arbol){
+  return avl_nodo_tamano(arbol->raiz);
+}
+
+/**
+ * avl_nodo_contar_menores: Funcion interna que retorna cuantos datos del arbol
+ * son menores que el dato dado, o menores o iguales si incluirIguales es 1.
+ */
+static int avl_nodo_contar_menores(AVL_Nodo* raiz, FuncionComparadora comp,
+  void* dato, int incluirIguales){
+  int menores = 0;
+  while (raiz != NULL)
+  {
+    int c = comp(raiz->dato, dato);
+    if (c < 0 || (c == 0 && incluirIguales))
+    {
+      menores += avl_nodo_tamano(raiz->izq) + 1;
+      raiz = raiz->der;
+    }
+    else if (c > 0)
+      raiz = raiz->izq;
+    else
+      return menores + avl_nodo_tamano(raiz->izq);
+  }
+  return menores;
+}
+
+/**
+ * avl_rango: retorna cuantos datos del arbol son menores que el dato dado
+ */
+int avl_rango(AVL arbol, void* dato){
+  return avl_nodo_contar_menores(arbol->raiz, arbol->comp, dato, 0);
 }
-static AVL_Nodo* avl_nodo_eliminar(AVL_Nodo* raiz, void* dato, FuncionComparadora comp, FuncionDestructora destr){
-  if (raiz == NULL )
+
+/**
+ * avl_seleccionar: retorna el k-esimo menor dato del arbol
+ */
+void* avl_seleccionar(AVL arbol, int k){
+  if (k < 0 || k >= avl_nelems(arbol))
     return NULL;
-  else if (comp(raiz->dato, dato) > 0)
-    raiz->izq = avl_nodo_eliminar(raiz->izq, dato, comp, destr);
-  else if (comp(raiz->dato,dato) < 0)
-    raiz->der = avl_nodo_eliminar(raiz->der, dato, comp, destr);
-  else{
-    if (!raiz->izq || !raiz->der)
+  AVL_Nodo* raiz = arbol->raiz;
+  for (;;)
+  {
+    int tamanoIzq = avl_nodo_tamano(raiz->izq);
+    if (k == tamanoIzq)
+      return raiz->dato;
+    if (k < tamanoIzq)
+      raiz = raiz->izq;
+    else
     {
-      AVL_Nodo* temp = (raiz->izq) ?  raiz->izq : raiz->der;
-      destr(raiz->dato);
-      free(raiz);
-      return temp;
+      k -= tamanoIzq + 1;
+      raiz = raiz->der;
+    }
+  }
+}
+
+/**
+ * avl_contar_rango: retorna cuantos datos del arbol estan entre lo y hi
+ */
+int avl_contar_rango(AVL arbol, void* lo, void* hi){
+  if (arbol->comp(lo, hi) > 0)
+    return 0;
+  return avl_nodo_contar_menores(arbol->raiz, arbol->comp, hi, 1) -
+         avl_nodo_contar_menores(arbol->raiz, arbol->comp, lo, 0);
+}
+
+/**
+ * Estructura del iterador.
+ * pila guarda el camino desde la raiz hasta el nodo actual (el tope), asi que
+ * el sucesor y el predecesor se encuentran sin punteros al padre. Con la pila
+ * vacia, lado indica si el iterador quedo despues del ultimo dato (1) o antes
+ * del primero (-1).
+ */
+struct _AVLIter {
+  AVL arbol;
+  AVL_Nodo* pila[ALTURA_MAXIMA];
+  int tope;
+  int lado;
+};
+
+/**
+ * avl_iter_nuevo: Funcion interna que retorna un iterador fuera del arbol, del
+ * lado dado.
+ */
+static AVLIter avl_iter_nuevo(AVL arbol, int lado){
+  AVLIter iter = malloc(sizeof(struct _AVLIter));
+  assert(iter);
+  iter->arbol = arbol;
+  iter->tope = 0;
+  iter->lado = lado;
+  return iter;
+}
+
+/**
+ * avl_iter_apilar: Funcion interna que apila el nodo y sus descendientes por
+ * izquierda (si haciaIzq es 1) o por derecha, dejando en el tope el menor o el
+ * mayor dato de su subarbol.
+ */
+static void avl_iter_apilar(AVLIter iter, AVL_Nodo* nodo, int haciaIzq){
+  for (; nodo != NULL; nodo = haciaIzq ? nodo->izq : nodo->der)
+  {
+    assert(iter->tope < ALTURA_MAXIMA);
+    iter->pila[iter->tope++] = nodo;
+  }
+}
+
+/**
+ * Retorna un iterador en el menor dato del arbol
+ */
+AVLIter avl_iter_crear(AVL arbol){
+  AVLIter iter = avl_iter_nuevo(arbol, 1);
+  avl_iter_apilar(iter, arbol->raiz, 1);
+  return iter;
+}
+
+/**
+ * avl_iter_cota: Funcion interna que retorna un iterador en el menor dato
+ * mayor o igual que el dato dado (si incluirIguales es 1) o estrictamente
+ * mayor. Baja desde la raiz comparando una vez por nodo y corta el camino en
+ * el ultimo nodo que cumplia la condicion.
+ */
+static AVLIter avl_iter_cota(AVL arbol, void* dato, int incluirIguales){
+  AVLIter iter = avl_iter_nuevo(arbol, 1);
+  int encontrado = 0;
+  for (AVL_Nodo* nodo = arbol->raiz; nodo != NULL; )
+  {
+    assert(iter->tope < ALTURA_MAXIMA);
+    iter->pila[iter->tope++] = nodo;
+    int c = arbol->comp(nodo->dato, dato);
+    if (c > 0 || (c == 0 && incluirIguales))
+    {
+      encontrado = iter->tope;
+      if (c == 0)
+        break;
+      nodo = nodo->izq;
     }
     else
+      nodo = nodo->der;
+  }
+  iter->tope = encontrado;
+  return iter;
+}
+
+/**
+ * avl_cota_inferior: retorna un iterador en el menor dato mayor o igual que
+ * el dato dado
+ */
+AVLIter avl_cota_inferior(AVL arbol, void* dato){
+  return avl_iter_cota(arbol, dato, 1);
+}
+
+/**
+ * avl_cota_superior: retorna un iterador en el menor dato mayor que el dato
+ * dado
+ */
+AVLIter avl_cota_superior(AVL arbol, void* dato){
+  return avl_iter_cota(arbol, dato, 0);
+}
+
+/**
+ * Retorna el dato actual del iterador, o NULL si esta fuera del arbol
+ */
+void* avl_iter_dato(AVLIter iter){
+  return (iter->tope > 0) ? iter->pila[iter->tope - 1]->dato : NULL;
+}
+
+/**
+ * avl_iter_mover: Funcion interna que mueve el iterador al sucesor (si
+ * adelante es 1) o al predecesor del dato actual y retorna el nuevo dato.
+ */
+static void* avl_iter_mover(AVLIter iter, int adelante){
+  if (iter->tope == 0)
+  {
+    // Desde afuera solo se puede volver a entrar por el extremo mas cercano.
+    if (iter->lado == (adelante ? -1 : 1))
+      avl_iter_apilar(iter, iter->arbol->raiz, adelante);
+    return avl_iter_dato(iter);
+  }
+  AVL_Nodo* actual = iter->pila[iter->tope - 1];
+  AVL_Nodo* hijo = adelante ? actual->der : actual->izq;
+  if (hijo != NULL)
+  {
+    // El siguiente es el extremo del subarbol de ese lado.
+    avl_iter_apilar(iter, hijo, adelante);
+    return avl_iter_dato(iter);
+  }
+  // Si no, se sube hasta llegar desde el otro lado.
+  for (;;)
+  {
+    hijo = iter->pila[--iter->tope];
+    if (iter->tope == 0)
     {
-      AVL_Nodo* sucesor = avl_min(raiz->der);
-      void* dato_temp = raiz->dato;
-      raiz->dato = sucesor->dato;
-      sucesor->dato = dato_temp;
-      raiz->der = avl_nodo_eliminar(raiz->der, sucesor->dato, comp, destr);
+      iter->lado = adelante ? 1 : -1;
+      return NULL;
     }
+    AVL_Nodo* padre = iter->pila[iter->tope - 1];
+    if ((adelante ? padre->izq : padre->der) == hijo)
+      return padre->dato;
   }
+}
+
+/**
+ * Avanza el iterador al siguiente dato y lo retorna
+ */
+void* avl_iter_siguiente(AVLIter iter){
+  return avl_iter_mover(iter, 1);
+}
+
+/**
+ * Retrocede el iterador al dato anterior y lo retorna
+ */
+void* avl_iter_anterior(AVLIter iter){
+  return avl_iter_mover(iter, 0);
+}
+
+/**
+ * Destruye el iterador
+ */
+void avl_iter_destruir(AVLIter iter){
+  free(iter);
+}
+
+/**
+ * avl_nodo_actualizar: Funcion interna que recalcula la altura y el tamano
+ * del nodo a partir de los de sus hijos.
+ */
+static void avl_nodo_actualizar(AVL_Nodo* raiz){
   raiz->altura = 1 + avl_nodo_max_altura_hijos(raiz);
+  avl_nodo_actualizar_tamano(raiz);
+}
+
+/**
+ * avl_nodo_join: Funcion interna que retorna un arbol AVL con los datos de
+ * izq, el de medio y los de der, sabiendo que los de izq son menores que el de
+ * medio y los de der, mayores. Baja por el costado del arbol mas alto hasta un
+ * subarbol de la altura del otro, y los cuelga de medio ahi; cuesta
+ * O(diferencia de alturas).
+ */
+static AVL_Nodo* avl_nodo_join(AVL_Nodo* izq, AVL_Nodo* medio, AVL_Nodo* der){
+  int alturaIzq = avl_nodo_altura(izq);
+  int alturaDer = avl_nodo_altura(der);
+  if (alturaIzq > alturaDer + 1)
+  {
+    izq->der = avl_nodo_join(izq->der, medio, der);
+    avl_nodo_actualizar(izq);
+    return avl_balancear_arbol(izq);
+  }
+  if (alturaDer > alturaIzq + 1)
+  {
+    der->izq = avl_nodo_join(izq, medio, der->izq);
+    avl_nodo_actualizar(der);
+    return avl_balancear_arbol(der);
+  }
+  medio->izq = izq;
+  medio->der = der;
+  avl_nodo_actualizar(medio);
+  return medio;
+}
+
+/**
+ * avl_nodo_quitar_maximo: Funcion interna que quita el nodo del mayor dato del
+ * arbol, lo guarda en maximo y retorna el arbol que queda.
+ */
+static AVL_Nodo* avl_nodo_quitar_maximo(AVL_Nodo* raiz, AVL_Nodo** maximo){
+  if (raiz->der == NULL)
+  {
+    *maximo = raiz;
+    return raiz->izq;
+  }
+  raiz->der = avl_nodo_quitar_maximo(raiz->der, maximo);
+  avl_nodo_actualizar(raiz);
   return avl_balancear_arbol(raiz);
 }
-AVL avl_eliminar(AVL arbol, void* dato){
-  arbol->raiz = avl_nodo_eliminar(arbol->raiz, dato, arbol->comp, arbol->destr);
-  return arbol;
+
+/**
+ * avl_nodo_join2: Funcion interna que retorna un arbol con los datos de izq y
+ * de der, sabiendo que los de izq son menores.
+ */
+static AVL_Nodo* avl_nodo_join2(AVL_Nodo* izq, AVL_Nodo* der){
+  if (izq == NULL)
+    return der;
+  AVL_Nodo* maximo;
+  izq = avl_nodo_quitar_maximo(izq, &maximo);
+  return avl_nodo_join(izq, maximo, der);
 }
 
 /**
- * avl_obtener_dato: retorna el puntero del dato que se busca
+ * avl_nodo_separar: Funcion interna que separa el arbol en el de los datos
+ * menores que el dato dado (menores) y el de los mayores (mayores), y retorna
+ * el nodo con el dato igual, suelto, o NULL si no lo hay. Compara una vez por
+ * nivel y cuesta O(log n).
  */
-static void* avl_nodo_obtener(AVL_Nodo* raiz, FuncionComparadora comp, void* dato){
+static AVL_Nodo* avl_nodo_separar(AVL_Nodo* raiz, void* dato, FuncionComparadora comp,
+  AVL_Nodo** menores, AVL_Nodo** mayores){
   if (raiz == NULL)
+  {
+    *menores = *mayores = NULL;
     return NULL;
-  else if (comp(raiz->dato, dato) == 0)
-    return raiz->dato;
-  else if (comp(raiz->dato, dato) > 0)
-    return avl_nodo_obtener(raiz->izq, comp, dato);
+  }
+  AVL_Nodo* izq = raiz->izq;
+  AVL_Nodo* der = raiz->der;
+  int c = comp(raiz->dato, dato);
+  if (c == 0)
+  {
+    *menores = izq;
+    *mayores = der;
+    raiz->izq = raiz->der = NULL;
+    avl_nodo_actualizar(raiz);
+    return raiz;
+  }
+  AVL_Nodo* igual;
+  if (c < 0)
+  {
+    igual = avl_nodo_separar(der, dato, comp, menores, mayores);
+    *menores = avl_nodo_join(izq, raiz, *menores);
+  }
   else
-    return avl_nodo_obtener(raiz->der, comp, dato);
+  {
+    igual = avl_nodo_separar(izq, dato, comp, menores, mayores);
+    *mayores = avl_nodo_join(*mayores, raiz, der);
+  }
+  return igual;
 }
-void* avl_obtener(AVL arbol, void * dato){
-  return avl_nodo_obtener(arbol->raiz, arbol->comp, dato);
+
+/**
+ * avl_arenas_unir: Funcion interna que prepara al arbol a para quedarse con
+ * los nodos de b. Si usan arenas distintas, la que solo usa uno de los dos
+ * arboles pasa a la otra, y a se queda con la que resulta. Aborta si no se
+ * puede: un arbol con arena y otro sin ella, o dos arenas compartidas.
+ */
+static void avl_arenas_unir(AVL a, AVL b){
+  if (a->arena == b->arena)
+  {
+    if (b->arena != NULL)
+      b->arena->referencias--;
+    return;
+  }
+  if (a->arena == NULL || b->arena == NULL ||
+      (a->arena->referencias > 1 && b->arena->referencias > 1))
+  {
+    fprintf(stderr, "avl: no se pueden unir los nodos de un arbol con arena "
+                    "y uno sin ella, ni de dos arenas compartidas\n");
+    abort();
+  }
+  if (b->arena->referencias == 1)
+    avl_arena_absorber(a->arena, b->arena);
+  else
+  {
+    avl_arena_absorber(b->arena, a->arena);
+    a->arena = b->arena;
+  }
+  b->arena = NULL;
+}
+
+/**
+ * Concatena dos arboles
+ */
+AVL avl_join(AVL izq, AVL der){
+  avl_arenas_unir(izq, der);
+  assert(izq->raiz == NULL || der->raiz == NULL ||
+         izq->comp(avl_seleccionar(izq, avl_nelems(izq) - 1),
+                   avl_seleccionar(der, 0)) < 0);
+  izq->raiz = avl_nodo_join2(izq->raiz, der->raiz);
+  free(der);
+  return izq;
+}
+
+/**
+ * Separa el arbol en los datos menores y los mayores o iguales que el dato
+ */
+void avl_split(AVL arbol, void* dato, AVL* menores, AVL* mayores){
+  AVL_Nodo* izq, * der;
+  AVL_Nodo* igual = avl_nodo_separar(arbol->raiz, dato, arbol->comp, &izq, &der);
+  if (igual != NULL)
+    der = avl_nodo_join(NULL, igual, der);
+  *mayores = avl_crear(arbol->copia, arbol->comp, arbol->destr);
+  (*mayores)->raiz = der;
+  // Los dos arboles siguen tomando nodos de la misma arena.
+  (*mayores)->arena = arbol->arena;
+  if (arbol->arena != NULL)
+    arbol->arena->referencias++;
+  arbol->raiz = izq;
+  *menores = arbol;
+}
+
+/**
+ * Operaciones de conjuntos: union, interseccion y diferencia con los
+ * algoritmos de divide y conquista basados en join (Blelloch, Ferizovic y Sun,
+ * "Just Join for Parallel Ordered Sets"). Se separa un arbol por la raiz del
+ * otro y se resuelven las dos mitades por separado, en paralelo si son
+ * grandes; el trabajo es O(m log(n/m + 1)) para arboles de m <= n datos.
+ */
+typedef enum {
+  AVL_UNION,
+  AVL_INTERSECCION,
+  AVL_DIFERENCIA
+} AVLOperacion;
+
+/**
+ * Contexto de una operacion de conjuntos: las funciones de cada arbol, la
+ * arena del resultado (NULL si no tiene) y cuantos hilos mas pueden crearse
+ * todavia (hilosLibres). candado protege a hilosLibres y a la lista libre de
+ * la arena.
+ */
+typedef struct {
+  AVLOperacion operacion;
+  FuncionComparadora comp;
+  FuncionDestructora destr1, destr2;
+  AVL_Arena* arena;
+  pthread_mutex_t candado;
+  int hilosLibres;
+} AVLContexto;
+
+/**
+ * avl_nodo_descartar: Funcion interna que destruye un nodo suelto y su dato.
+ */
+static void avl_nodo_descartar(AVLContexto* contexto, AVL_Nodo* nodo,
+  FuncionDestructora destr){
+  if (destr != NULL)
+    destr(nodo->dato);
+  if (contexto->arena == NULL)
+  {
+    free(nodo);
+    return;
+  }
+  pthread_mutex_lock(&contexto->candado);
+  avl_nodo_liberar(nodo, contexto->arena);
+  pthread_mutex_unlock(&contexto->candado);
+}
+
+/**
+ * avl_nodo_descartar_todos: Funcion interna que destruye un arbol y sus datos
+ * durante una operacion de conjuntos.
+ */
+static void avl_nodo_descartar_todos(AVLContexto* contexto, AVL_Nodo* raiz,
+  FuncionDestructora destr){
+  if (contexto->arena == NULL)
+  {
+    avl_nodo_destruir(raiz, destr, NULL);
+    return;
+  }
+  if (raiz != NULL)
+  {
+    avl_nodo_descartar_todos(contexto, raiz->izq, destr);
+    avl_nodo_descartar_todos(contexto, raiz->der, destr);
+    avl_nodo_descartar(contexto, raiz, destr);
+  }
+}
+
+/**
+ * Subproblema de una operacion de conjuntos, para resolverlo en otro hilo.
+ */
+typedef struct {
+  AVLContexto* contexto;
+  AVL_Nodo* t1, * t2;
+  AVL_Nodo* resultado;
+} AVLTarea;
+
+static int hilosConjuntos = 0;
+
+/**
+ * Fija cuantos hilos usan como maximo las operaciones de conjuntos
+ */
+void avl_conjuntos_hilos(int hilos){
+  hilosConjuntos = hilos;
+}
+
+static AVL_Nodo* avl_nodo_operar(AVLContexto* contexto, AVL_Nodo* t1, AVL_Nodo* t2);
+
+static void* avl_tarea_ejecutar(void* tarea){
+  AVLTarea* t = tarea;
+  t->resultado = avl_nodo_operar(t->contexto, t->t1, t->t2);
+  return NULL;
+}
+
+/**
+ * avl_tomar_hilo: Funcion interna que retorna 1 si el subproblema es grande y
+ * queda un hilo libre (que pasa a estar ocupado), y 0 si no.
+ */
+static int avl_tomar_hilo(AVLContexto* contexto, AVL_Nodo* t1, AVL_Nodo* t2){
+  if (avl_nodo_tamano(t1) + avl_nodo_tamano(t2) < CORTE_PARALELO)
+    return 0;
+  pthread_mutex_lock(&contexto->candado);
+  int libre = contexto->hilosLibres > 0;
+  if (libre)
+    contexto->hilosLibres--;
+  pthread_mutex_unlock(&contexto->candado);
+  return libre;
+}
+
+/**
+ * avl_nodo_operar: Funcion interna que aplica la operacion del contexto a los
+ * arboles t1 y t2 y retorna el resultado. Los nodos que no forman parte del
+ * resultado se destruyen; de los datos repetidos queda el de t1.
+ */
+static AVL_Nodo* avl_nodo_operar(AVLContexto* contexto, AVL_Nodo* t1, AVL_Nodo* t2){
+  if (t1 == NULL || t2 == NULL)
+  {
+    if (contexto->operacion == AVL_UNION)
+      return (t1 != NULL) ? t1 : t2;
+    if (contexto->operacion == AVL_DIFERENCIA)
+    {
+      avl_nodo_descartar_todos(contexto, t2, contexto->destr2);
+      return t1;
+    }
+    avl_nodo_descartar_todos(contexto, t1, contexto->destr1);
+    avl_nodo_descartar_todos(contexto, t2, contexto->destr2);
+    return NULL;
+  }
+
+  // La union y la interseccion separan t2 por la raiz de t1; la diferencia
+  // separa t1 por la raiz de t2.
+  AVL_Nodo* raiz = (contexto->operacion == AVL_DIFERENCIA) ? t2 : t1;
+  AVL_Nodo* otro = (contexto->operacion == AVL_DIFERENCIA) ? t1 : t2;
+  AVL_Nodo* menores, * mayores;
+  AVL_Nodo* igual = avl_nodo_separar(otro, raiz->dato, contexto->comp, &menores, &mayores);
+  AVLTarea izq = {contexto, raiz->izq, menores, NULL};
+  AVLTarea der = {contexto, raiz->der, mayores, NULL};
+  if (contexto->operacion == AVL_DIFERENCIA)
+  {
+    izq = (AVLTarea){contexto, menores, raiz->izq, NULL};
+    der = (AVLTarea){contexto, mayores, raiz->der, NULL};
+  }
+
+  pthread_t hilo;
+  int paralelo = avl_tomar_hilo(contexto, izq.t1, izq.t2) &&
+                 pthread_create(&hilo, NULL, avl_tarea_ejecutar, &izq) == 0;
+  if (!paralelo)
+    avl_tarea_ejecutar(&izq);
+  avl_tarea_ejecutar(&der);
+  if (paralelo)
+  {
+    pthread_join(hilo, NULL);
+    pthread_mutex_lock(&contexto->candado);
+    contexto->hilosLibres++;
+    pthread_mutex_unlock(&contexto->candado);
+  }
+
+  switch (contexto->operacion)
+  {
+  case AVL_UNION:
+    if (igual != NULL)
+      avl_nodo_descartar(contexto, igual, contexto->destr2);
+    return avl_nodo_join(izq.resultado, raiz, der.resultado);
+  case AVL_INTERSECCION:
+    if (igual == NULL)
+    {
+      avl_nodo_descartar(contexto, raiz, contexto->destr1);
+      return avl_nodo_join2(izq.resultado, der.resultado);
+    }
+    avl_nodo_descartar(contexto, igual, contexto->destr2);
+    return avl_nodo_join(izq.resultado, raiz, der.resultado);
+  default:
+    avl_nodo_descartar(contexto, raiz, contexto->destr2);
+    if (igual != NULL)
+      avl_nodo_descartar(contexto, igual, contexto->destr1);
+    return avl_nodo_join2(izq.resultado, der.resultado);
+  }
+}
+
+/**
+ * avl_operar: Funcion interna que aplica la operacion a los arboles a y b,
+ * dejando el resultado en a y destruyendo b.
+ */
+static AVL avl_operar(AVLOperacion operacion, AVL a, AVL b){
+  avl_arenas_unir(a, b);
+  AVLContexto contexto;
+  contexto.operacion = operacion;
+  contexto.comp = a->comp;
+  contexto.destr1 = a->destr;
+  contexto.destr2 = b->destr;
+  contexto.arena = a->arena;
+  int hilos = hilosConjuntos;
+  if (hilos <= 0)
+  {
+    long procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+    hilos = (procesadores > 0) ? (int)procesadores : 1;
+  }
+  contexto.hilosLibres = hilos - 1;
+  int error = pthread_mutex_init(&contexto.candado, NULL);
+  assert(error == 0);
+  (void)error;
+
+  a->raiz = avl_nodo_operar(&contexto, a->raiz, b->raiz);
+  pthread_mutex_destroy(&contexto.candado);
+  free(b);
+  return a;
+}
+
+/**
+ * Union de dos arboles
+ */
+AVL avl_union(AVL a, AVL b){
+  return avl_operar(AVL_UNION, a, b);
+}
+
+/**
+ * Interseccion de dos arboles
+ */
+AVL avl_interseccion(AVL a, AVL b){
+  return avl_operar(AVL_INTERSECCION, a, b);
+}
+
+/**
+ * Diferencia de dos arboles
+ */
+AVL avl_diferencia(AVL a, AVL b){
+  return avl_operar(AVL_DIFERENCIA, a, b);
 }
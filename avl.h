@@ -1,6 +1,8 @@
 #ifndef __AVL_H__
 #define __AVL_H__
 
+#include <stddef.h>
+
 typedef void *(*FuncionCopiadora)(void *dato);
 typedef int (*FuncionComparadora)(void *, void *);
 typedef void (*FuncionDestructora)(void *dato);
@@ -16,15 +18,24 @@ typedef enum {
  * Estructura del nodo del arbol AVL.
  * Tiene un puntero al dato (dato),
  * un puntero al nodo raiz del subarbol izquierdo (izq),
- * un puntero al nodo raiz del subarbol derecho (der), y
- * un entero para representar la altura del arbol (altura)
+ * un puntero al nodo raiz del subarbol derecho (der),
+ * un entero para representar la altura del arbol (altura), y
+ * un entero con el numero de nodos del arbol (tamano), que ocupa el espacio
+ * que de otro modo quedaria como relleno.
  */
 typedef struct _AVL_Nodo {
   void* dato;
   struct _AVL_Nodo* izq, * der;
   int altura;
+  int tamano;
 } AVL_Nodo;
 
+/**
+ * Arena de nodos: reparte los nodos de bloques de muchos nodos contiguos y
+ * recicla los de los datos eliminados. Su estructura es interna a avl.c.
+ */
+typedef struct _AVL_Arena AVL_Arena;
+
 /**
  * Estructura del arbol AVL.
  * Tiene un puntero al nodo raiz (raiz),
@@ -33,7 +44,10 @@ typedef struct _AVL_Nodo {
  * un puntero a funcion (comp) que compara dos datos y retorna un entero
  * negativo si el primero es menor que el segundo, 0 si son iguales, y un entero
  * positivo en caso contrario,
- * y un puntero a una funcion (destr) que recibe un dato y lo destruye.
+ * un puntero a una funcion (destr) que recibe un dato y lo destruye (NULL si
+ * los datos no se destruyen),
+ * y un puntero a la arena de la que se toman los nodos (arena), NULL si cada
+ * nodo se aloca por separado.
  * En esta implementación, los punteros a funcion necesarios para manipular los
  * datos se mantienen en la estructura para evitar pasarlos por parametro a las
  * demas funciones.
@@ -43,11 +57,12 @@ struct _AVL {
   FuncionCopiadora copia;
   FuncionComparadora comp;
   FuncionDestructora destr;
+  AVL_Arena* arena;
 };
 
 typedef struct _AVL* AVL;
 
-int avl_balance;
+typedef struct _AVLIter* AVLIter;
 
 /**
  * Retorna un arbol AVL vacio
@@ -55,7 +70,26 @@ int avl_balance;
 AVL avl_crear(FuncionCopiadora copia, FuncionComparadora comp, FuncionDestructora destr);
 
 /**
- * Destruye el arbol y sus datos.
+ * Retorna un arbol AVL vacio cuyos nodos se toman de una arena, en bloques de
+ * nodosPorBloque nodos (0 para el valor predeterminado). Los nodos de los datos
+ * eliminados se reciclan para las siguientes inserciones, y al destruir el
+ * arbol se liberan los bloques enteros; si destr es NULL ni siquiera se
+ * recorren los nodos.
+ */
+AVL avl_crear_con_arena(FuncionCopiadora copia, FuncionComparadora comp,
+                        FuncionDestructora destr, unsigned nodosPorBloque);
+
+/**
+ * Retorna un arbol AVL con copias de los n datos del arreglo (los repetidos se
+ * guardan una sola vez), perfectamente balanceado. Si los datos ya estan
+ * ordenados el arbol se arma en O(n); si no, se ordenan antes. Los nodos se
+ * toman de una arena, en un solo bloque y contiguos en inorden.
+ */
+AVL avl_crear_desde_arreglo(void** datos, size_t n, FuncionCopiadora copia,
+                            FuncionComparadora comp, FuncionDestructora destr);
+
+/**
+ * Destruye el arbol y sus datos (si destr no es NULL).
  */
 void avl_destruir(AVL arbol);
 
@@ -95,4 +129,135 @@ AVL avl_eliminar(AVL arbol, void* dato);
  * avl_obtener_dato: retorna el puntero del dato que se busca
  */
 void* avl_obtener(AVL arbol, void* dato);
+
+/**
+ * Retorna el numero de datos del arbol.
+ */
+int avl_nelems(AVL arbol);
+
+/**
+ * avl_rango: retorna cuantos datos del arbol son menores que el dato dado (que
+ * no necesita estar en el arbol). Si el dato esta, es su posicion en inorden,
+ * contando desde 0. O(log n).
+ */
+int avl_rango(AVL arbol, void* dato);
+
+/**
+ * avl_seleccionar: retorna el k-esimo menor dato del arbol, contando desde 0,
+ * o NULL si k no esta entre 0 y avl_nelems - 1. O(log n).
+ */
+void* avl_seleccionar(AVL arbol, int k);
+
+/**
+ * avl_contar_rango: retorna cuantos datos del arbol estan entre lo y hi,
+ * ambos incluidos. O(log n).
+ */
+int avl_contar_rango(AVL arbol, void* lo, void* hi);
+
+/**
+ * Iteradores en inorden. Un iterador esta en un dato del arbol o fuera de el
+ * (antes del primero o despues del ultimo), y se mueve en O(1) amortizado sin
+ * funciones visitantes, asi que un recorrido puede pausarse entre llamadas.
+ * Recorrer el rango [lo, hi):
+ *   AVLIter iter = avl_cota_inferior(arbol, lo);
+ *   for (void* dato = avl_iter_dato(iter);
+ *        dato != NULL && comp(dato, hi) < 0; dato = avl_iter_siguiente(iter))
+ *     ...
+ *   avl_iter_destruir(iter);
+ * cuesta O(log n + k) para k datos. Mientras se use el iterador el arbol no
+ * debe modificarse.
+ */
+
+/**
+ * Retorna un iterador en el menor dato del arbol.
+ */
+AVLIter avl_iter_crear(AVL arbol);
+
+/**
+ * avl_cota_inferior: retorna un iterador en el menor dato mayor o igual que el
+ * dato dado (despues del ultimo si no hay ninguno). O(log n).
+ */
+AVLIter avl_cota_inferior(AVL arbol, void* dato);
+
+/**
+ * avl_cota_superior: retorna un iterador en el menor dato estrictamente mayor
+ * que el dato dado (despues del ultimo si no hay ninguno). O(log n).
+ */
+AVLIter avl_cota_superior(AVL arbol, void* dato);
+
+/**
+ * Retorna el dato actual del iterador (sin copiarlo), o NULL si esta fuera
+ * del arbol.
+ */
+void* avl_iter_dato(AVLIter iter);
+
+/**
+ * Avanza el iterador al dato siguiente en inorden y lo retorna, o retorna
+ * NULL si ya no hay mas. Desde antes del primer dato avanza al primero.
+ */
+void* avl_iter_siguiente(AVLIter iter);
+
+/**
+ * Retrocede el iterador al dato anterior en inorden y lo retorna, o retorna
+ * NULL si ya no hay mas. Desde despues del ultimo dato retrocede al ultimo.
+ */
+void* avl_iter_anterior(AVLIter iter);
+
+/**
+ * Destruye el iterador.
+ */
+void avl_iter_destruir(AVLIter iter);
+
+/**
+ * Operaciones de division y union de arboles. Los nodos pasan de un arbol a
+ * otro sin copiarse. Con arboles con arena (los de avl_crear_con_arena y
+ * avl_crear_desde_arreglo), avl_split deja a los dos arboles compartiendo la
+ * arena, asi que no pueden modificarse desde hilos distintos a la vez; la
+ * arena se libera al destruir el ultimo. avl_join y las operaciones de
+ * conjuntos dejan en el resultado los bloques de las dos arenas. No pueden
+ * combinarse un arbol con arena y otro sin ella, ni dos arboles con arenas
+ * distintas que ya comparten otros arboles: el programa termina con un
+ * mensaje de error. Las operaciones de conjuntos reparten el trabajo entre
+ * varios hilos (hay que compilar con -pthread), y las funciones destructoras
+ * de los arboles deben poder llamarse desde cualquiera de ellos.
+ */
+
+/**
+ * avl_join: concatena los arboles, sabiendo que todos los datos de izq son
+ * menores que los de der. Retorna izq con todos los datos y destruye der (sin
+ * sus datos). O(log n).
+ */
+AVL avl_join(AVL izq, AVL der);
+
+/**
+ * avl_split: separa el arbol en el de los datos menores que el dato dado
+ * (menores, que reutiliza arbol) y el de los mayores o iguales (mayores).
+ * O(log n).
+ */
+void avl_split(AVL arbol, void* dato, AVL* menores, AVL* mayores);
+
+/**
+ * Fija cuantos hilos usan como maximo las operaciones de conjuntos (0, el
+ * valor inicial, para usar uno por procesador).
+ */
+void avl_conjuntos_hilos(int hilos);
+
+/**
+ * avl_union: retorna a con los datos de a y de b, y destruye b. De los datos
+ * que estan en los dos queda el de a (el de b se destruye).
+ * O(m log(n/m + 1)) para arboles de m <= n datos.
+ */
+AVL avl_union(AVL a, AVL b);
+
+/**
+ * avl_interseccion: retorna a con los datos de a que tambien estan en b, y
+ * destruye b y los datos descartados. O(m log(n/m + 1)).
+ */
+AVL avl_interseccion(AVL a, AVL b);
+
+/**
+ * avl_diferencia: retorna a con los datos de a que no estan en b, y destruye
+ * b y los datos descartados. O(m log(n/m + 1)).
+ */
+AVL avl_diferencia(AVL a, AVL b);
 #endif /* __AVL_H__*/
\ No newline at end of file
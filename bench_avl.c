@@ -0,0 +1,191 @@
+/**
+ * Banco de pruebas de construccion y destruccion de arboles AVL, con nodos
+ * alocados de a uno o tomados de una arena, y de sus operaciones de conjuntos:
+ *
+ *   gcc -std=c11 -O2 -DNDEBUG -pthread bench_avl.c avl.c -o bench_avl
+ *   ./bench_avl [n] > resultados.csv
+ *
+ * Inserta n enteros (10 millones si no se indica) en orden aleatorio, elimina
+ * la mitad, los vuelve a insertar (con arena, en los nodos reciclados), busca
+ * cada entero y destruye el arbol. Cada configuracion imprime una linea CSV
+ * por operacion:
+ *   nodos,datos,hilos,n,operacion,ns_op,comp_op
+ * comp_op es el promedio de llamadas a la funcion comparadora por operacion.
+ * nodos es malloc o arena. Con datos propios cada dato es una copia alocada
+ * que se destruye con el arbol; con datos ajenos los datos son del programa
+ * (destr es NULL) y el arbol con arena se destruye liberando solo sus bloques.
+ *
+ * Despues mide la escalabilidad de avl_union, avl_interseccion y
+ * avl_diferencia entre un arbol con la primera mitad de los enteros y otro con
+ * la mitad del medio (se solapan en un cuarto), con 1, 2, 4... hilos hasta el
+ * numero de procesadores, con los arboles armados insertando de a uno (malloc)
+ * o con avl_crear_desde_arreglo (arena). ns_op es el tiempo por dato de los dos arboles, y
+ * comp_op solo se cuenta con un hilo (con mas, las comparaciones se hacen con
+ * una funcion que no cuenta, para no compartir el contador).
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "avl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static void *copiar(void *dato) {
+  int *copia = malloc(sizeof(int));
+  if (copia == NULL)
+    abort();
+  *copia = *(int *)dato;
+  return copia;
+}
+
+static void *identidad(void *dato) { return dato; }
+
+static unsigned long comparaciones;
+
+static int comparar(void *dato1, void *dato2) {
+  comparaciones++;
+  int a = *(int *)dato1, b = *(int *)dato2;
+  return (a > b) - (a < b);
+}
+
+static int comparar_sin_contar(void *dato1, void *dato2) {
+  int a = *(int *)dato1, b = *(int *)dato2;
+  return (a > b) - (a < b);
+}
+
+static void destruir(void *dato) { free(dato); }
+
+/**
+ * Retorna los segundos de un reloj monotono.
+ */
+static double segundos(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Imprime la operacion y reinicia el contador de comparaciones.
+ */
+static void imprimir(const char *nodos, const char *datos, int hilos, unsigned n,
+                     const char *operacion, double tiempo, unsigned ops) {
+  printf("%s,%s,%d,%u,%s,%.2f,%.2f\n", nodos, datos, hilos, n, operacion,
+         tiempo * 1e9 / ops, (double)comparaciones / ops);
+  comparaciones = 0;
+}
+
+/**
+ * Mide una configuracion sobre los enteros de claves.
+ */
+static void medir(int conArena, int propios, int *claves, unsigned n) {
+  const char *nodos = conArena ? "arena" : "malloc";
+  const char *datos = propios ? "propios" : "ajenos";
+  FuncionCopiadora copia = propios ? copiar : identidad;
+  FuncionDestructora destr = propios ? destruir : NULL;
+  AVL arbol = conArena ? avl_crear_con_arena(copia, comparar, destr, 0)
+                       : avl_crear(copia, comparar, destr);
+
+  comparaciones = 0;
+  double inicio = segundos();
+  for (unsigned i = 0; i < n; i++)
+    avl_insertar(arbol, &claves[i]);
+  imprimir(nodos, datos, 1, n, "insertar", segundos() - inicio, n);
+
+  inicio = segundos();
+  for (unsigned i = 0; i < n; i += 2)
+    avl_eliminar(arbol, &claves[i]);
+  imprimir(nodos, datos, 1, n, "eliminar", segundos() - inicio, (n + 1) / 2);
+
+  inicio = segundos();
+  for (unsigned i = 0; i < n; i += 2)
+    avl_insertar(arbol, &claves[i]);
+  imprimir(nodos, datos, 1, n, "reinsertar", segundos() - inicio, (n + 1) / 2);
+
+  inicio = segundos();
+  unsigned encontrados = 0;
+  for (unsigned i = 0; i < n; i++)
+    encontrados += avl_buscar(arbol, &claves[i]);
+  imprimir(nodos, datos, 1, n, "buscar", segundos() - inicio, n);
+  if (encontrados != n)
+    abort();
+
+  inicio = segundos();
+  avl_destruir(arbol);
+  imprimir(nodos, datos, 1, n, "destruir", segundos() - inicio, n);
+}
+
+/**
+ * Retorna un arbol con los enteros de claves[desde, hasta): sin arena,
+ * insertandolos de a uno, o con arena, con avl_crear_desde_arreglo.
+ */
+static AVL armar(int conArena, int *claves, unsigned desde, unsigned hasta,
+                 FuncionComparadora comp) {
+  if (conArena) {
+    void **datos = malloc(sizeof(void *) * (hasta - desde));
+    if (datos == NULL)
+      abort();
+    for (unsigned i = desde; i < hasta; i++)
+      datos[i - desde] = &claves[i];
+    AVL arbol = avl_crear_desde_arreglo(datos, hasta - desde, copiar, comp,
+                                        destruir);
+    free(datos);
+    return arbol;
+  }
+  AVL arbol = avl_crear(copiar, comp, destruir);
+  for (unsigned i = desde; i < hasta; i++)
+    avl_insertar(arbol, &claves[i]);
+  return arbol;
+}
+
+/**
+ * Mide las operaciones de conjuntos con el numero de hilos dado.
+ */
+static void medir_conjuntos(int conArena, int *claves, unsigned n, int hilos) {
+  const char *nombres[3] = {"union", "interseccion", "diferencia"};
+  AVL (*operaciones[3])(AVL, AVL) = {avl_union, avl_interseccion,
+                                     avl_diferencia};
+  FuncionComparadora comp = (hilos == 1) ? comparar : comparar_sin_contar;
+  avl_conjuntos_hilos(hilos);
+  for (int i = 0; i < 3; i++) {
+    AVL a = armar(conArena, claves, 0, n / 2, comp);
+    AVL b = armar(conArena, claves, n / 4, n / 4 + n / 2, comp);
+    comparaciones = 0;
+    double inicio = segundos();
+    a = operaciones[i](a, b);
+    imprimir(conArena ? "arena" : "malloc", "propios", hilos, n, nombres[i],
+             segundos() - inicio, 2 * (n / 2));
+    avl_destruir(a);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  unsigned n = (argc > 1 && atol(argv[1]) > 0) ? (unsigned)atol(argv[1])
+                                               : 10000000;
+  int *claves = malloc(sizeof(int) * n);
+  if (claves == NULL)
+    abort();
+  // Permutacion aleatoria de 0 a n - 1.
+  srand(1);
+  for (unsigned i = 0; i < n; i++)
+    claves[i] = (int)i;
+  for (unsigned i = n - 1; i > 0; i--) {
+    unsigned j = (unsigned)(((unsigned long)rand() * RAND_MAX + rand()) % (i + 1));
+    int temp = claves[i];
+    claves[i] = claves[j];
+    claves[j] = temp;
+  }
+
+  for (int propios = 1; propios >= 0; propios--)
+    for (int conArena = 0; conArena <= 1; conArena++)
+      medir(conArena, propios, claves, n);
+
+  long procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+  for (int conArena = 0; conArena <= 1; conArena++) {
+    for (int hilos = 1; hilos < procesadores; hilos *= 2)
+      medir_conjuntos(conArena, claves, n, hilos);
+    medir_conjuntos(conArena, claves, n,
+                    (procesadores > 0) ? (int)procesadores : 1);
+  }
+  free(claves);
+  return 0;
+}
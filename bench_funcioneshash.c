@@ -0,0 +1,324 @@
+/**
+ * Banco de pruebas de calidad y velocidad de las funciones de funcioneshash.h,
+ * comparadas con hashes ingenuos como los que escribiria un usuario:
+ *
+ *   gcc -std=c11 -O2 -DNDEBUG -DTABLAHASH_INSTRUMENTAR bench_funcioneshash.c \
+ *       funcioneshash.c tablahashlp.c -o bench_funcioneshash
+ *   ./bench_funcioneshash [-c] [capacidad] > sondeos.csv
+ *   ./bench_funcioneshash velocidad [-c] [n] > velocidad.csv
+ *
+ * Con -c se imprime primero la cabecera del CSV.
+ *
+ * Sin modo mide la distribucion de sondeos de tablahashlp.c con cada hash: la
+ * tabla tiene una capacidad fija (2^16 si no se indica), se llena al CARGA sin
+ * redimensionar, se busca una vez cada clave insertada y otras tantas
+ * ausentes, y se imprime el histograma de sondeos de cada tipo de busqueda:
+ *   hash,claves,n,busqueda,sondeos_medio,sondeo_maximo,sondeos,fraccion
+ * con una linea por cada numero de sondeos con alguna busqueda (la ultima
+ * posicion, TABLAHASH_HISTOGRAMA - 1, acumula las mas largas). sondeo_maximo
+ * solo se registra para las busquedas exitosas. Con un hash que reparte bien
+ * los promedios rondan los del sondeo lineal con claves al azar: con carga 0.8,
+ * 3 sondeos por acierto y 13 por fallo. Claves:
+ *  - secuencial: enteros 0, 1, 2, ...
+ *  - multiplos: enteros multiplos de 1024, que coinciden en los bits bajos.
+ *  - aleatorias: enteros al azar.
+ *  - cadenas: cadenas "clave0", "clave1", ...
+ * Los enteros se prueban con la identidad, con un hash multiplicativo y con
+ * hash_entero; las cadenas con la suma de sus caracteres, con djb2 y con
+ * hash_cadena. tablahashlp.c ya mezcla el hash con Fibonacci antes de
+ * reducirlo a la capacidad; compilandolo ademas con -DTABLAHASH_MODULO se ve
+ * como reparte cada hash reducido con %, como lo hacia la tabla original.
+ *
+ * El modo velocidad mide el tiempo por hash sobre n claves (2^20) de cada
+ * tipo y, para hash_bytes, sobre entradas de 4 a 4096 bytes:
+ *   hash,largo,n,ns_hash,gb_s
+ * largo es el numero de bytes de cada clave (en las cadenas, el de la mas
+ * larga) y gb_s los gigabytes de claves hasheados por segundo.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "funcioneshash.h"
+#include "tablahash.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CARGA 0.8
+#define MIN_BYTES (1ul << 28)
+#define MAX_LARGO 4096
+
+static void *copiar_entero(void *dato) {
+  int *copia = malloc(sizeof(int));
+  if (copia == NULL)
+    abort();
+  *copia = *(int *)dato;
+  return copia;
+}
+
+static int comparar_entero(void *dato1, void *dato2) {
+  int a = *(int *)dato1, b = *(int *)dato2;
+  return (a > b) - (a < b);
+}
+
+static void *copiar_cadena(void *dato) {
+  char *copia = malloc(strlen(dato) + 1);
+  if (copia == NULL)
+    abort();
+  return strcpy(copia, dato);
+}
+
+static int comparar_cadena(void *dato1, void *dato2) {
+  return strcmp(dato1, dato2);
+}
+
+static void destruir(void *dato) { free(dato); }
+
+/**
+ * Hashes ingenuos, para comparar.
+ */
+static unsigned hash_identidad(void *dato) { return *(unsigned *)dato; }
+
+static unsigned hash_multiplicativo(void *dato) {
+  return *(unsigned *)dato * 31u + 7u;
+}
+
+static unsigned hash_suma(void *dato) {
+  unsigned h = 0;
+  for (const unsigned char *c = dato; *c != '\0'; c++)
+    h += *c;
+  return h;
+}
+
+static unsigned hash_djb2(void *dato) {
+  unsigned h = 5381;
+  for (const unsigned char *c = dato; *c != '\0'; c++)
+    h = h * 33 + *c;
+  return h;
+}
+
+typedef struct {
+  const char *nombre;
+  FuncionHash hash;
+} Hash;
+
+static const Hash hashesEnteros[] = {{"identidad", hash_identidad},
+                                     {"multiplicativo", hash_multiplicativo},
+                                     {"hash_entero", hash_entero}};
+
+static const Hash hashesCadenas[] = {{"suma", hash_suma},
+                                     {"djb2", hash_djb2},
+                                     {"hash_cadena", hash_cadena}};
+
+#define NUM_HASHES 3
+
+typedef enum { SECUENCIAL, MULTIPLOS, ALEATORIAS, CADENAS, NUM_CLAVES } Claves;
+
+static const char *nombresClaves[NUM_CLAVES] = {"secuencial", "multiplos",
+                                                "aleatorias", "cadenas"};
+
+/**
+ * Generador pseudoaleatorio (splitmix64).
+ */
+static uint64_t aleatorio(uint64_t *estado) {
+  uint64_t z = (*estado += 0x9E3779B97F4A7C15u);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Retorna los segundos de un reloj monotono.
+ */
+static double segundos(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Retorna un arreglo con n claves distintas del tipo dado: enteros o, para
+ * CADENAS, punteros a cadenas alocadas.
+ */
+static void **crear_claves(Claves tipo, unsigned n) {
+  void **claves = malloc(sizeof(void *) * n);
+  if (claves == NULL)
+    abort();
+  // Las claves aleatorias no se repiten: el xor con una constante al azar y
+  // la multiplicacion por un impar son permutaciones de los enteros de 32 bits.
+  uint64_t estado = 0x2545F4914F6CDD1Du;
+  unsigned ruido = (unsigned)aleatorio(&estado);
+  for (unsigned i = 0; i < n; i++) {
+    if (tipo == CADENAS) {
+      char *cadena = malloc(16);
+      if (cadena == NULL)
+        abort();
+      snprintf(cadena, 16, "clave%u", i);
+      claves[i] = cadena;
+      continue;
+    }
+    int *entero = malloc(sizeof(int));
+    if (entero == NULL)
+      abort();
+    if (tipo == SECUENCIAL)
+      *entero = (int)i;
+    else if (tipo == MULTIPLOS)
+      *entero = (int)(i << 10);
+    else
+      *entero = (int)((i ^ ruido) * 0x9E3779B1u);
+    claves[i] = entero;
+  }
+  return claves;
+}
+
+static void destruir_claves(void **claves, unsigned n) {
+  for (unsigned i = 0; i < n; i++)
+    free(claves[i]);
+  free(claves);
+}
+
+/**
+ * Imprime el histograma de sondeos de las busquedas exitosas o fallidas.
+ */
+static void imprimir_histograma(const char *hash, Claves tipo, unsigned n,
+                                const TablaHashEstadisticas *e, int exito) {
+  const unsigned long *histograma =
+      exito ? e->histogramaExitosas : e->histogramaFallidas;
+  unsigned long busquedas = exito ? e->busquedasExitosas : e->busquedasFallidas;
+  for (int s = 0; s < TABLAHASH_HISTOGRAMA; s++)
+    if (histograma[s] > 0)
+      printf("%s,%s,%u,%s,%.2f,%u,%d,%.5f\n", hash, nombresClaves[tipo], n,
+             exito ? "acierto" : "fallo",
+             exito ? e->sondeosExitosa : e->sondeosFallida,
+             exito ? e->sondeoMaximo : 0, s,
+             (double)histograma[s] / busquedas);
+}
+
+/**
+ * Llena una tabla de la capacidad dada con las claves usando el hash, y mide
+ * los sondeos de buscar cada una y otras tantas ausentes.
+ */
+static void medir_sondeos(const Hash *hash, Claves tipo, void **claves,
+                          unsigned capacidad) {
+  TablaHashOpciones opciones = {0};
+  opciones.cargaMaxima = 1;
+  int cadenas = tipo == CADENAS;
+  TablaHash tabla = tablahash_crear_con_opciones(
+      capacidad, cadenas ? copiar_cadena : copiar_entero,
+      cadenas ? comparar_cadena : comparar_entero, destruir, hash->hash,
+      &opciones);
+  unsigned n = (unsigned)(tablahash_capacidad(tabla) * CARGA);
+  // claves[0, n) se insertan y claves[n, 2n) quedan ausentes.
+  for (unsigned i = 0; i < n; i++)
+    tablahash_insertar(tabla, claves[i]);
+  for (unsigned i = 0; i < 2 * n; i++)
+    if ((tablahash_buscar(tabla, claves[i]) != NULL) != (i < n))
+      abort();
+  TablaHashEstadisticas estadisticas;
+  tablahash_estadisticas(tabla, &estadisticas);
+  if (!estadisticas.instrumentada) {
+    fprintf(stderr, "compilar tablahashlp.c con -DTABLAHASH_INSTRUMENTAR\n");
+    exit(1);
+  }
+  imprimir_histograma(hash->nombre, tipo, n, &estadisticas, 1);
+  imprimir_histograma(hash->nombre, tipo, n, &estadisticas, 0);
+  fflush(stdout);
+  tablahash_destruir(tabla);
+}
+
+static void medir_calidad(unsigned capacidad) {
+  for (Claves tipo = 0; tipo < NUM_CLAVES; tipo++) {
+    // Con capacidad redondeada hacia arriba alcanzan 2 * capacidad claves.
+    void **claves = crear_claves(tipo, 4 * capacidad);
+    const Hash *hashes = (tipo == CADENAS) ? hashesCadenas : hashesEnteros;
+    for (int h = 0; h < NUM_HASHES; h++)
+      medir_sondeos(&hashes[h], tipo, claves, capacidad);
+    destruir_claves(claves, 4 * capacidad);
+  }
+}
+
+static volatile unsigned long sumidero;
+
+/**
+ * Mide el tiempo por hash sobre las n claves, repitiendo la pasada hasta
+ * procesar al menos MIN_BYTES bytes de claves.
+ */
+static void medir_hash(const char *nombre, FuncionHash hash, void **claves,
+                       unsigned n, size_t largo) {
+  unsigned pasadas = (unsigned)(MIN_BYTES / ((unsigned long)n * largo)) + 1;
+  unsigned long suma = 0;
+  double inicio = segundos();
+  for (unsigned p = 0; p < pasadas; p++)
+    for (unsigned i = 0; i < n; i++)
+      suma += hash(claves[i]);
+  double tiempo = segundos() - inicio;
+  sumidero += suma;
+  double hashes = (double)pasadas * n;
+  printf("%s,%zu,%u,%.2f,%.2f\n", nombre, largo, n, tiempo * 1e9 / hashes,
+         hashes * largo / tiempo / 1e9);
+  fflush(stdout);
+}
+
+static void medir_bytes(unsigned n, size_t largo) {
+  // Las entradas se toman de un mismo bufer, desplazadas un byte cada una,
+  // para que tambien se lean sin alineacion.
+  uint8_t *bufer = malloc(largo + 64);
+  if (bufer == NULL)
+    abort();
+  uint64_t estado = 1;
+  for (size_t i = 0; i < largo + 64; i++)
+    bufer[i] = (uint8_t)aleatorio(&estado);
+  unsigned pasadas = (unsigned)(MIN_BYTES / ((unsigned long)n * largo)) + 1;
+  uint64_t suma = 0;
+  double inicio = segundos();
+  for (unsigned p = 0; p < pasadas; p++)
+    for (unsigned i = 0; i < n; i++)
+      suma += hash_bytes(bufer + (i & 63), largo, i);
+  double tiempo = segundos() - inicio;
+  sumidero += suma;
+  double hashes = (double)pasadas * n;
+  printf("hash_bytes,%zu,%u,%.2f,%.2f\n", largo, n, tiempo * 1e9 / hashes,
+         hashes * largo / tiempo / 1e9);
+  fflush(stdout);
+  free(bufer);
+}
+
+static void medir_velocidad(unsigned n) {
+  void **enteros = crear_claves(ALEATORIAS, n);
+  for (int h = 0; h < NUM_HASHES; h++)
+    medir_hash(hashesEnteros[h].nombre, hashesEnteros[h].hash, enteros, n,
+               sizeof(int));
+  destruir_claves(enteros, n);
+
+  // Cadenas de 7 a 10 caracteres ("clave0" a "clave99999...").
+  void **cadenas = crear_claves(CADENAS, n);
+  for (int h = 0; h < NUM_HASHES; h++)
+    medir_hash(hashesCadenas[h].nombre, hashesCadenas[h].hash, cadenas, n,
+               strlen(cadenas[n - 1]));
+  destruir_claves(cadenas, n);
+
+  for (size_t largo = 4; largo <= MAX_LARGO; largo *= 2)
+    medir_bytes(largo <= 64 ? n : n / 64 + 1, largo);
+}
+
+int main(int argc, char *argv[]) {
+  int velocidad = argc > 1 && strcmp(argv[1], "velocidad") == 0;
+  unsigned n = velocidad ? 1u << 20 : 1u << 16;
+  for (int i = 1 + velocidad; i < argc; i++) {
+    if (strcmp(argv[i], "-c") == 0)
+      printf(velocidad ? "hash,largo,n,ns_hash,gb_s\n"
+                       : "hash,claves,n,busqueda,sondeos_medio,sondeo_maximo,"
+                         "sondeos,fraccion\n");
+    else if (atol(argv[i]) > 0)
+      n = (unsigned)atol(argv[i]);
+    else {
+      fprintf(stderr, "%s: argumento desconocido %s\n", argv[0], argv[i]);
+      return 1;
+    }
+  }
+  if (velocidad)
+    medir_velocidad(n);
+  else
+    medir_calidad(n);
+  return 0;
+}
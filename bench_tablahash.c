@@ -0,0 +1,928 @@
+/**
+ * Banco de pruebas de rendimiento de las implementaciones de tablahash.h.
+ * Se compila una vez por implementacion, enlazando el mismo programa con cada
+ * una y pasando su nombre en BACKEND:
+ *
+ *   gcc -std=c11 -O2 -DNDEBUG -DBACKEND='"sc"' bench_tablahash.c \
+ *       tablahashsc.c funcioneshash.c -lm -o bench_sc
+ *   gcc -std=c11 -O2 -DNDEBUG -DBACKEND='"lp"' -DCON_FILTRO bench_tablahash.c \
+ *       tablahashlp.c funcioneshash.c -lm -o bench_lp
+ *   gcc -std=c11 -O2 -DNDEBUG -DBACKEND='"en"' bench_tablahash.c \
+ *       tablahashen.c funcioneshash.c -lm -o bench_en
+ *   gcc -std=c11 -O2 -DNDEBUG -DBACKEND='"simd"' bench_tablahash.c \
+ *       tablahashsimd.c funcioneshash.c -lm -o bench_simd
+ *   gcc -std=c11 -O2 -DNDEBUG -DBACKEND='"cuckoo"' -DCON_CUCKOO \
+ *       bench_tablahash.c tablahashcuckoo.c funcioneshash.c -lm -o bench_cuckoo
+ *
+ *   for b in sc lp en simd cuckoo; do ./bench_$b; done > resultados.csv
+ *
+ * Cada ejecucion imprime lineas CSV (la cabecera solo si se pasa -c):
+ *   backend,carga,tamano,n,operacion,ns_op,bytes_dato,rss_max_kb,encontrados
+ * Con un numero como argumento se mide solo ese numero de datos, en lugar de
+ * los tamanos de L1, L2, L3 y 10 veces L3.
+ *
+ * Los datos son int alocados por la funcion copiadora, como los usaria un
+ * programa cualquiera. Cargas de claves:
+ *  - uniforme: claves dispersas, accedidas al azar.
+ *  - zipf: las mismas claves, accedidas segun una distribucion de Zipf
+ *    (theta = 0.99), de modo que unas pocas concentran casi todos los accesos.
+ *  - secuencial: claves 0, 1, 2, ... insertadas y accedidas en orden.
+ *  - adversaria: claves multiplos de una potencia de 2 con un hash que es la
+ *    identidad, como el de un usuario que no mezcla los bits; todas coinciden
+ *    en los bits bajos.
+ * Operaciones, medidas en este orden sobre la misma tabla: insertar los n
+ * datos, n busquedas exitosas, n busquedas fallidas, n operaciones mezcladas
+ * (60% busquedas, 20% inserciones de claves nuevas y 20% eliminaciones) y
+ * eliminar los n datos originales (algunos ya eliminados por la mezcla).
+ * Las busquedas se repiten hasta sumar al menos MIN_OPS, para que las tablas
+ * chicas tambien se midan con precision.
+ * bytes_dato es la memoria alocada despues de insertar dividida por n, y
+ * rss_max_kb el pico de memoria residente. Cada combinacion de carga y tamano
+ * se mide en un proceso aparte para que estos valores no se mezclen.
+ *
+ * Con un modo como primer argumento se hace en cambio otra medicion, con su
+ * propio CSV (la cabecera tambien con -c) y su propio numero de datos
+ * predeterminado, que puede darse despues del modo:
+ *  - factores [capacidad]: busquedas exitosas y fallidas con la tabla llena
+ *    al 0.5, 0.6, 0.7, 0.8 y 0.9 de una capacidad fija (2^20), sin
+ *    redimensionar. Para comparar simd con lp y sc a igual carga:
+ *      for b in sc lp simd; do ./bench_$b factores; done
+ *    backend,factor,n,operacion,ns_op,sondeos_medio,sondeo_maximo,encontrados
+ *    sondeos_medio solo se calcula si la implementacion se compila con
+ *    -DTABLAHASH_INSTRUMENTAR (si no, es 0). sc encuentra menos datos que
+ *    los insertados, porque descarta los que colisionan.
+ *  - latencia [n]: latencia de cada una de n inserciones (2^22) desde una
+ *    tabla chica, que redimensiona muchas veces, con la redimension completa
+ *    (pasos 0) y con la incremental (pasos 16). Las implementaciones sin
+ *    redimension incremental (simd, cuckoo) dan lo mismo en las dos. lp
+ *    compilado con -DCON_FILTRO repite las dos con un filtro de Bloom de 10
+ *    bits por dato (bits_filtro 10), que se rearma durante la migracion.
+ *    backend,pasos,bits_filtro,n,ns_op,p50_ns,p99_ns,p999_ns,maximo_ns
+ *    Cada tiempo incluye la lectura del reloj (unas decenas de ns).
+ *  - barrido [n]: busquedas exitosas y fallidas con la tabla llena al 0.75
+ *    de cada capacidad potencia de dos de 2^10 a n (2^22), sin redimensionar.
+ *    Para comparar la reduccion del hash con % y con Fibonacci:
+ *      gcc ... -DBACKEND='"lp-modulo"' -DTABLAHASH_MODULO ... -o bench_lp-modulo
+ *      for b in lp lp-modulo; do ./bench_$b barrido; done
+ *    backend,capacidad,n,operacion,ns_op,sondeos_medio
+ *  - churn [n]: 10^8 operaciones alternando insertar una clave nueva y
+ *    eliminar la mas vieja, con n datos vivos (2^20). Cada vigesimo imprime
+ *    el tiempo por operacion, la capacidad, las casillas borradas, los datos
+ *    fuera de su lugar, el sondeo maximo y los sondeos medios de una muestra
+ *    de busquedas (estos solo con -DTABLAHASH_INSTRUMENTAR). Con la
+ *    eliminacion por corrimiento de lp los sondeos quedan estables.
+ *    backend,ops,n,ns_op,capacidad,borradas,desbordados,sondeo_maximo,
+ *    sondeos_acierto,sondeos_fallo
+ *  - filtro [n]: solo en lp compilado con -DCON_FILTRO. Con n / 16 y n datos
+ *    (2^22), tiempo de las busquedas exitosas, de las fallidas y de una mezcla
+ *    con 80% de fallidas, sin filtro de Bloom (bits_dato 0) y con 8, 10 y 16
+ *    bits por dato, y la fraccion de fallidas que el filtro dejo pasar.
+ *    backend,n,bits_dato,ns_acierto,ns_fallo,ns_mezcla,falsos_positivos
+ *  - cache [n]: solo compilando con -DCON_CACHE y enlazando cache.c, con
+ *    cualquier implementacion menos sc. Una traza de 10^7 accesos a n claves
+ *    (2^20) con la distribucion de Zipf: cada acceso busca la clave en la
+ *    cache y la inserta si falta. Con LRU y CLOCK, y con capacidad para el
+ *    1%, 5% y 10% de las claves:
+ *      gcc ... -DCON_CACHE bench_tablahash.c cache.c tablahashlp.c ...
+ *    backend,politica,n,capacidad,ops,ns_op,aciertos,desalojos
+ *    aciertos es la fraccion de accesos que encontraron la clave.
+ *  - desalojos [n]: solo en cuckoo compilado con -DCON_CUCKOO. Desalojos por
+ *    insercion, tiempo de insercion y sondeos de las busquedas a medida que
+ *    se llena una tabla sin redimensionar, y la carga maxima alcanzada antes
+ *    de la primera insercion sin lugar, con capacidades de n / 256, n / 16 y
+ *    n (2^20).
+ *    backend,capacidad,factor,operacion,ns_op,desplazados_op,sondeos_medio
+ *    La ultima linea de cada capacidad tiene operacion carga_maxima y la
+ *    carga en factor.
+ */
+#define _GNU_SOURCE
+#include "funcioneshash.h"
+#include "tablahash.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef CON_CUCKOO
+#include "tablahashcuckoo.h"
+#endif
+#ifdef CON_FILTRO
+#include "tablahashlp.h"
+#endif
+#ifdef CON_CACHE
+#include "cache.h"
+#endif
+
+#ifndef BACKEND
+#define BACKEND "?"
+#endif
+#define MIN_OPS (1u << 22)
+#define BYTES_POR_DATO 32
+#define THETA 0.99
+#define CARGA_BARRIDO 0.75
+#define OPS_CHURN 100000000ul
+#define MUESTRA_CHURN (1u << 16)
+#define FALLOS_FILTRO 80
+#define OPS_CACHE 10000000u
+
+typedef enum { UNIFORME, ZIPF, SECUENCIAL, ADVERSARIA, NUM_CARGAS } Carga;
+
+static const char *nombresCargas[NUM_CARGAS] = {"uniforme", "zipf",
+                                                "secuencial", "adversaria"};
+
+static void *copiar(void *dato) {
+  int *copia = malloc(sizeof(int));
+  if (copia == NULL)
+    abort();
+  *copia = *(int *)dato;
+  return copia;
+}
+
+static int comparar(void *dato1, void *dato2) {
+  int a = *(int *)dato1, b = *(int *)dato2;
+  return (a > b) - (a < b);
+}
+
+static void destruir(void *dato) { free(dato); }
+
+static unsigned hash_identidad(void *dato) { return *(unsigned *)dato; }
+
+/**
+ * Generador pseudoaleatorio (splitmix64).
+ */
+static uint64_t aleatorio(uint64_t *estado) {
+  uint64_t z = (*estado += 0x9E3779B97F4A7C15u);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Generador de rangos de Zipf en [0, n) segun Gray et al., "Quickly
+ * generating billion-record synthetic databases": O(n) al crearlo y O(1) por
+ * rango. El rango 0 es el mas frecuente.
+ */
+typedef struct {
+  unsigned n;
+  double zetan, alfa, eta, umbral;
+} Zipf;
+
+static Zipf zipf_crear(unsigned n) {
+  Zipf zipf;
+  double zeta2 = 1 + pow(0.5, THETA);
+  zipf.n = n;
+  zipf.zetan = 0;
+  for (unsigned i = 1; i <= n; i++)
+    zipf.zetan += 1 / pow(i, THETA);
+  zipf.alfa = 1 / (1 - THETA);
+  zipf.eta = (1 - pow(2.0 / n, 1 - THETA)) / (1 - zeta2 / zipf.zetan);
+  zipf.umbral = zeta2;
+  return zipf;
+}
+
+static unsigned zipf_rango(Zipf *zipf, uint64_t *estado) {
+  double u = (aleatorio(estado) >> 11) * (1.0 / 9007199254740992.0);
+  double uz = u * zipf->zetan;
+  if (uz < 1)
+    return 0;
+  if (uz < zipf->umbral)
+    return 1;
+  unsigned rango =
+      (unsigned)(zipf->n * pow(zipf->eta * u - zipf->eta + 1, zipf->alfa));
+  return (rango < zipf->n) ? rango : zipf->n - 1;
+}
+
+/**
+ * Retorna la i-esima clave de la carga. Las claves 0 a n - 1 son las que se
+ * insertan y las siguientes, las de las busquedas fallidas y las inserciones
+ * de la mezcla. desplazamiento es el de la carga adversaria.
+ */
+static int clave(Carga carga, unsigned i, unsigned desplazamiento) {
+  switch (carga) {
+  case SECUENCIAL:
+    return (int)i;
+  case ADVERSARIA:
+    return (int)(i << desplazamiento);
+  default: {
+    // Permutacion de los 32 bits (cada paso es invertible), asi que las claves
+    // son distintas.
+    unsigned x = i;
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return (int)x;
+  }
+  }
+}
+
+/**
+ * Retorna los segundos de un reloj monotono.
+ */
+static double segundos(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Retorna los bytes alocados con malloc, o 0 si no se pueden consultar.
+ */
+static size_t memoria_alocada(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Retorna el pico de memoria residente del proceso, en KiB.
+ */
+static long rss_maximo(void) {
+  struct rusage uso;
+  getrusage(RUSAGE_SELF, &uso);
+  return uso.ru_maxrss;
+}
+
+/**
+ * Datos comunes a las lineas de una medicion.
+ */
+typedef struct {
+  Carga carga;
+  const char *tamano;
+  unsigned n;
+  double bytesDato;
+} Medicion;
+
+static void imprimir(Medicion *m, const char *operacion, double tiempo,
+                     unsigned long ops, unsigned long encontrados) {
+  printf("%s,%s,%s,%u,%s,%.2f,%.1f,%ld,%lu\n", BACKEND,
+         nombresCargas[m->carga], m->tamano, m->n, operacion,
+         tiempo * 1e9 / ops, m->bytesDato, rss_maximo(), encontrados);
+}
+
+/**
+ * Busca las claves de indices, repitiendo el recorrido hasta sumar MIN_OPS
+ * busquedas. Retorna cuantas encontro en total y guarda en ops cuantas hizo.
+ */
+static unsigned long buscar(TablaHash tabla, const int *claves,
+                            const unsigned *indices, unsigned n,
+                            unsigned long *ops) {
+  unsigned long encontrados = 0;
+  *ops = 0;
+  do {
+    for (unsigned i = 0; i < n; i++) {
+      int k = claves[indices[i]];
+      encontrados += (tablahash_buscar(tabla, &k) != NULL);
+    }
+    *ops += n;
+  } while (*ops < MIN_OPS);
+  return encontrados;
+}
+
+/**
+ * Mide todas las operaciones de una carga con n datos.
+ */
+static void medir(Carga carga, const char *tamano, unsigned n) {
+  uint64_t estado = 0x2545F4914F6CDD1Du ^ ((uint64_t)carga << 32) ^ n;
+  unsigned desplazamiento = 16;
+  while (desplazamiento > 0 && ((2ul * n) << desplazamiento) > 0x80000000ul)
+    desplazamiento--;
+
+  // Claves 0 a n - 1 presentes y n a 2n - 1 ausentes.
+  int *claves = malloc(sizeof(int) * 2 * n);
+  unsigned *indices = malloc(sizeof(unsigned) * n);
+  unsigned *mezcla = malloc(sizeof(unsigned) * n);
+  if (claves == NULL || indices == NULL || mezcla == NULL)
+    abort();
+  for (unsigned i = 0; i < 2 * n; i++)
+    claves[i] = clave(carga, i, desplazamiento);
+
+  // Orden de las busquedas exitosas.
+  Zipf zipf;
+  if (carga == ZIPF)
+    zipf = zipf_crear(n);
+  for (unsigned i = 0; i < n; i++) {
+    if (carga == SECUENCIAL)
+      indices[i] = i;
+    else if (carga == ZIPF)
+      indices[i] = zipf_rango(&zipf, &estado);
+    else
+      indices[i] = aleatorio(&estado) % n;
+  }
+  // Mezcla: cada valor codifica la operacion en los 2 bits bajos.
+  for (unsigned i = 0, nuevas = 0; i < n; i++) {
+    unsigned r = aleatorio(&estado) % 10;
+    if (r < 6)
+      mezcla[i] = indices[i] << 2;
+    else if (r < 8)
+      mezcla[i] = ((n + nuevas++) << 2) | 1;
+    else
+      mezcla[i] = ((unsigned)(aleatorio(&estado) % n) << 2) | 2;
+  }
+
+  FuncionHash hash = (carga == ADVERSARIA) ? hash_identidad : hash_entero;
+  size_t memoriaInicial = memoria_alocada();
+  TablaHash tabla = tablahash_crear(16, copiar, comparar, destruir, hash);
+  Medicion m = {carga, tamano, n, 0};
+  unsigned long ops, encontrados;
+
+  double inicio = segundos();
+  for (unsigned i = 0; i < n; i++)
+    tablahash_insertar(tabla, &claves[i]);
+  double tiempo = segundos() - inicio;
+  size_t memoria = memoria_alocada();
+  m.bytesDato = (memoria > memoriaInicial)
+                    ? (double)(memoria - memoriaInicial) / n
+                    : 0;
+  imprimir(&m, "insertar", tiempo, n, (unsigned long)tablahash_nelems(tabla));
+
+  inicio = segundos();
+  encontrados = buscar(tabla, claves, indices, n, &ops);
+  imprimir(&m, "acierto", segundos() - inicio, ops, encontrados);
+
+  for (unsigned i = 0; i < n; i++)
+    indices[i] = n + i;
+  inicio = segundos();
+  encontrados = buscar(tabla, claves, indices, n, &ops);
+  imprimir(&m, "fallo", segundos() - inicio, ops, encontrados);
+
+  encontrados = 0;
+  inicio = segundos();
+  for (unsigned i = 0; i < n; i++) {
+    int k = claves[mezcla[i] >> 2];
+    switch (mezcla[i] & 3) {
+    case 0:
+      encontrados += (tablahash_buscar(tabla, &k) != NULL);
+      break;
+    case 1:
+      tablahash_insertar(tabla, &k);
+      break;
+    default:
+      tablahash_eliminar(tabla, &k);
+    }
+  }
+  imprimir(&m, "mezcla", segundos() - inicio, n, encontrados);
+
+  inicio = segundos();
+  for (unsigned i = 0; i < n; i++)
+    tablahash_eliminar(tabla, &claves[i]);
+  tiempo = segundos() - inicio;
+  imprimir(&m, "eliminar", tiempo, n, (unsigned long)tablahash_nelems(tabla));
+
+  tablahash_destruir(tabla);
+  free(claves);
+  free(indices);
+  free(mezcla);
+}
+
+/**
+ * Retorna el promedio de sondeos de las busquedas (exitosas o fallidas)
+ * hechas entre las estadisticas antes y despues, o 0 si la tabla no esta
+ * instrumentada.
+ */
+static double sondeos_medios(const TablaHashEstadisticas *antes,
+                             const TablaHashEstadisticas *despues, int exito) {
+  unsigned long b0 = exito ? antes->busquedasExitosas : antes->busquedasFallidas;
+  unsigned long b1 = exito ? despues->busquedasExitosas : despues->busquedasFallidas;
+  double s0 = exito ? antes->sondeosExitosa : antes->sondeosFallida;
+  double s1 = exito ? despues->sondeosExitosa : despues->sondeosFallida;
+  return (b1 > b0) ? (s1 * b1 - s0 * b0) / (b1 - b0) : 0;
+}
+
+/**
+ * Modo factores: llena una tabla de capacidad fija hasta cada factor de carga
+ * de 0.5 a 0.9 y mide busquedas exitosas y fallidas en cada uno. La carga
+ * maxima se pide lo mas alta posible (cada implementacion la baja a su tope)
+ * para que la tabla no redimensione antes del 0.9; si igual lo hace (cuckoo,
+ * cuando una insercion no encuentra lugar), el factor informado es el real.
+ */
+static void medir_factores(unsigned n) {
+  TablaHashOpciones opciones = {0};
+  opciones.cargaMaxima = 1;
+  TablaHash tabla = tablahash_crear_con_opciones(n, copiar, comparar, destruir,
+                                                 hash_entero, &opciones);
+  unsigned capacidad = (unsigned)tablahash_capacidad(tabla);
+  uint64_t estado = 0x2545F4914F6CDD1Du;
+  int *claves = malloc(sizeof(int) * 2 * capacidad);
+  unsigned *indices = malloc(sizeof(unsigned) * capacidad);
+  if (claves == NULL || indices == NULL)
+    abort();
+  // Claves 0 a capacidad - 1 para insertar, y las siguientes ausentes.
+  for (unsigned i = 0; i < 2 * capacidad; i++)
+    claves[i] = clave(UNIFORME, i, 0);
+
+  unsigned insertadas = 0;
+  for (int decimos = 5; decimos <= 9; decimos++) {
+    unsigned objetivo = (unsigned)((unsigned long)capacidad * decimos / 10);
+    for (; insertadas < objetivo; insertadas++)
+      tablahash_insertar(tabla, &claves[insertadas]);
+    double factor = (double)tablahash_nelems(tabla) / tablahash_capacidad(tabla);
+
+    for (int exito = 1; exito >= 0; exito--) {
+      for (unsigned i = 0; i < insertadas; i++)
+        indices[i] = exito ? aleatorio(&estado) % insertadas
+                           : capacidad + aleatorio(&estado) % capacidad;
+      TablaHashEstadisticas antes, despues;
+      tablahash_estadisticas(tabla, &antes);
+      unsigned long ops;
+      double inicio = segundos();
+      unsigned long encontrados = buscar(tabla, claves, indices, insertadas, &ops);
+      double tiempo = segundos() - inicio;
+      tablahash_estadisticas(tabla, &despues);
+      printf("%s,%.3f,%u,%s,%.2f,%.2f,%u,%lu\n", BACKEND, factor, insertadas,
+             exito ? "acierto" : "fallo", tiempo * 1e9 / ops,
+             sondeos_medios(&antes, &despues, exito), despues.sondeoMaximo,
+             encontrados);
+    }
+  }
+  tablahash_destruir(tabla);
+  free(claves);
+  free(indices);
+}
+
+static int comparar_tiempos(const void *a, const void *b) {
+  unsigned x = *(const unsigned *)a, y = *(const unsigned *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Inserta las n claves en una tabla nueva con la redimension incremental
+ * dada y un filtro de bitsFiltro bits por dato (0 sin filtro), tomando el
+ * tiempo de cada insercion por separado, e imprime los percentiles.
+ */
+static void medir_latencia_pasos(const int *claves, unsigned n, unsigned pasos,
+                                 unsigned bitsFiltro) {
+  unsigned *tiempos = malloc(sizeof(unsigned) * n);
+  if (tiempos == NULL)
+    abort();
+  TablaHash tabla = tablahash_crear(16, copiar, comparar, destruir, hash_entero);
+  tablahash_redimension_incremental(tabla, pasos);
+#ifdef CON_FILTRO
+  tablahash_lp_filtro(tabla, bitsFiltro);
+#endif
+  double total = 0;
+  for (unsigned i = 0; i < n; i++) {
+    double inicio = segundos();
+    tablahash_insertar(tabla, (void *)&claves[i]);
+    double tiempo = segundos() - inicio;
+    total += tiempo;
+    tiempos[i] = (unsigned)(tiempo * 1e9);
+  }
+  tablahash_destruir(tabla);
+  qsort(tiempos, n, sizeof(unsigned), comparar_tiempos);
+  printf("%s,%u,%u,%u,%.2f,%u,%u,%u,%u\n", BACKEND, pasos, bitsFiltro, n,
+         total * 1e9 / n,
+         tiempos[n / 2], tiempos[(unsigned long)n * 99 / 100],
+         tiempos[(unsigned long)n * 999 / 1000], tiempos[n - 1]);
+  free(tiempos);
+}
+
+/**
+ * Modo latencia: inserta n datos con la redimension completa (pasos 0) y con
+ * la incremental. Con la redimension completa, la insercion que dispara la
+ * redimension paga la reubicacion de todos los datos. Cada configuracion se
+ * mide en un proceso aparte: si no, la memoria que libera una tabla cambia
+ * como malloc atiende los arreglos grandes de la siguiente.
+ */
+static void medir_latencia(unsigned n) {
+  const unsigned pasos[] = {0, 16};
+#ifdef CON_FILTRO
+  const unsigned bitsFiltro[] = {0, 10};
+#else
+  const unsigned bitsFiltro[] = {0};
+#endif
+  int *claves = malloc(sizeof(int) * n);
+  if (claves == NULL)
+    abort();
+  for (unsigned i = 0; i < n; i++)
+    claves[i] = clave(UNIFORME, i, 0);
+
+  for (size_t b = 0; b < sizeof(bitsFiltro) / sizeof(bitsFiltro[0]); b++)
+    for (size_t p = 0; p < sizeof(pasos) / sizeof(pasos[0]); p++) {
+      fflush(stdout);
+      pid_t hijo = fork();
+      if (hijo == 0) {
+        medir_latencia_pasos(claves, n, pasos[p], bitsFiltro[b]);
+        fflush(stdout);
+        _exit(0);
+      }
+      int estado;
+      if (hijo < 0 || waitpid(hijo, &estado, 0) < 0 || !WIFEXITED(estado) ||
+          WEXITSTATUS(estado) != 0)
+        fprintf(stderr, "%s: fallo la medicion latencia/%u/%u\n", BACKEND,
+                pasos[p], bitsFiltro[b]);
+    }
+  free(claves);
+}
+
+/**
+ * Modo barrido: para cada capacidad potencia de dos de 2^10 a n, llena una
+ * tabla de esa capacidad hasta CARGA_BARRIDO sin redimensionar y mide
+ * busquedas exitosas y fallidas. Compilando lp con y sin TABLAHASH_MODULO se
+ * compara el costo de reducir el hash con % y con Fibonacci a igual capacidad,
+ * desde tablas que caben en L1 hasta tablas que no caben en L3.
+ */
+static void medir_barrido(unsigned n) {
+  for (unsigned long capacidad = 1u << 10; capacidad <= n; capacidad *= 2) {
+    TablaHashOpciones opciones = {0};
+    opciones.cargaMaxima = 1;
+    TablaHash tabla = tablahash_crear_con_opciones(
+        (unsigned)capacidad, copiar, comparar, destruir, hash_entero, &opciones);
+    unsigned real = (unsigned)tablahash_capacidad(tabla);
+    unsigned datos = (unsigned)(real * CARGA_BARRIDO);
+    uint64_t estado = 0x2545F4914F6CDD1Du ^ real;
+    int *claves = malloc(sizeof(int) * 2 * datos);
+    unsigned *indices = malloc(sizeof(unsigned) * datos);
+    if (claves == NULL || indices == NULL)
+      abort();
+    for (unsigned i = 0; i < 2 * datos; i++)
+      claves[i] = clave(UNIFORME, i, 0);
+    for (unsigned i = 0; i < datos; i++)
+      tablahash_insertar(tabla, &claves[i]);
+
+    for (int exito = 1; exito >= 0; exito--) {
+      for (unsigned i = 0; i < datos; i++)
+        indices[i] = exito ? aleatorio(&estado) % datos
+                           : datos + aleatorio(&estado) % datos;
+      TablaHashEstadisticas antes, despues;
+      tablahash_estadisticas(tabla, &antes);
+      unsigned long ops;
+      double inicio = segundos();
+      buscar(tabla, claves, indices, datos, &ops);
+      double tiempo = segundos() - inicio;
+      tablahash_estadisticas(tabla, &despues);
+      printf("%s,%u,%u,%s,%.2f,%.2f\n", BACKEND, real, datos,
+             exito ? "acierto" : "fallo", tiempo * 1e9 / ops,
+             sondeos_medios(&antes, &despues, exito));
+      fflush(stdout);
+    }
+    tablahash_destruir(tabla);
+    free(claves);
+    free(indices);
+  }
+}
+
+/**
+ * Modo churn: mantiene n datos vivos en una ventana deslizante, insertando
+ * una clave nueva y eliminando la mas vieja, hasta OPS_CHURN operaciones. En
+ * cada vigesimo informa el tiempo por operacion y el estado de la tabla, y
+ * mide los sondeos de MUESTRA_CHURN busquedas exitosas y fallidas, para ver
+ * que las cadenas de sondeo no crecen con las eliminaciones.
+ */
+static void medir_churn(unsigned n) {
+  TablaHash tabla = tablahash_crear(16, copiar, comparar, destruir, hash_entero);
+  unsigned *indices = malloc(sizeof(unsigned) * MUESTRA_CHURN);
+  if (indices == NULL)
+    abort();
+  uint64_t estado = 0x2545F4914F6CDD1Du ^ n;
+  for (unsigned i = 0; i < n; i++) {
+    int k = clave(UNIFORME, i, 0);
+    tablahash_insertar(tabla, &k);
+  }
+  // La ventana viva es [siguiente - n, siguiente).
+  unsigned siguiente = n;
+  unsigned long hechas = 0;
+  for (int vigesimos = 1; vigesimos <= 20; vigesimos++) {
+    unsigned long objetivo = OPS_CHURN / 20 * vigesimos;
+    double inicio = segundos();
+    for (; hechas < objetivo; hechas += 2, siguiente++) {
+      int nueva = clave(UNIFORME, siguiente, 0);
+      int vieja = clave(UNIFORME, siguiente - n, 0);
+      tablahash_insertar(tabla, &nueva);
+      tablahash_eliminar(tabla, &vieja);
+    }
+    double tiempo = segundos() - inicio;
+
+    // Las claves de la muestra se toman de las vivas y de las ya eliminadas.
+    unsigned encontrados[2] = {0, 0};
+    double sondeos[2];
+    for (int exito = 1; exito >= 0; exito--) {
+      unsigned desde = exito ? siguiente - n : siguiente - 2 * n;
+      for (unsigned i = 0; i < MUESTRA_CHURN; i++)
+        indices[i] = desde + (unsigned)(aleatorio(&estado) % n);
+      TablaHashEstadisticas antes, despues;
+      tablahash_estadisticas(tabla, &antes);
+      for (unsigned i = 0; i < MUESTRA_CHURN; i++) {
+        int k = clave(UNIFORME, indices[i], 0);
+        encontrados[exito] += (tablahash_buscar(tabla, &k) != NULL);
+      }
+      tablahash_estadisticas(tabla, &despues);
+      sondeos[exito] = sondeos_medios(&antes, &despues, exito);
+    }
+    if (encontrados[1] != MUESTRA_CHURN || encontrados[0] != 0)
+      abort();
+    TablaHashEstadisticas estadisticas;
+    tablahash_estadisticas(tabla, &estadisticas);
+    printf("%s,%lu,%u,%.2f,%u,%u,%u,%u,%.2f,%.2f\n", BACKEND, hechas, n,
+           tiempo * 1e9 / (OPS_CHURN / 20), estadisticas.capacidad,
+           estadisticas.borradas, estadisticas.desbordados,
+           estadisticas.sondeoMaximo, sondeos[1], sondeos[0]);
+    fflush(stdout);
+  }
+  tablahash_destruir(tabla);
+  free(indices);
+}
+
+#ifdef CON_FILTRO
+/**
+ * Modo filtro (solo lp): con n / 16 y con n datos, mide busquedas exitosas,
+ * fallidas y una mezcla con FALLOS_FILTRO% de fallidas, sin filtro de Bloom y
+ * con cada numero de bits por dato de bitsFiltro, sobre la misma tabla.
+ */
+static void medir_filtro(unsigned n) {
+  const unsigned bitsFiltro[] = {0, 8, 10, 16};
+  for (unsigned divisor = 16; divisor >= 1; divisor /= 16) {
+    unsigned datos = n / divisor;
+    TablaHash tabla =
+        tablahash_crear(16, copiar, comparar, destruir, hash_entero);
+    uint64_t estado = 0x2545F4914F6CDD1Du ^ datos;
+    int *claves = malloc(sizeof(int) * 2 * datos);
+    unsigned *indices[3];
+    for (int o = 0; o < 3; o++)
+      indices[o] = malloc(sizeof(unsigned) * datos);
+    if (claves == NULL || indices[0] == NULL || indices[1] == NULL ||
+        indices[2] == NULL)
+      abort();
+    for (unsigned i = 0; i < 2 * datos; i++)
+      claves[i] = clave(UNIFORME, i, 0);
+    for (unsigned i = 0; i < datos; i++)
+      tablahash_insertar(tabla, &claves[i]);
+    // indices[0]: fallidas, indices[1]: exitosas, indices[2]: mezcla.
+    for (unsigned i = 0; i < datos; i++) {
+      indices[0][i] = datos + aleatorio(&estado) % datos;
+      indices[1][i] = aleatorio(&estado) % datos;
+      indices[2][i] = (aleatorio(&estado) % 100 < FALLOS_FILTRO)
+                          ? indices[0][i] : indices[1][i];
+    }
+
+    for (size_t b = 0; b < sizeof(bitsFiltro) / sizeof(bitsFiltro[0]); b++) {
+      tablahash_lp_filtro(tabla, bitsFiltro[b]);
+      double ns[3];
+      double falsosPositivos = 0;
+      for (int o = 0; o < 3; o++) {
+        unsigned long ops;
+        double inicio = segundos();
+        buscar(tabla, claves, indices[o], datos, &ops);
+        ns[o] = (segundos() - inicio) * 1e9 / ops;
+        // Antes de la mezcla, que tambien cuenta sus fallidas.
+        if (o == 0)
+          falsosPositivos = tablahash_lp_falsos_positivos(tabla);
+      }
+      printf("%s,%u,%u,%.2f,%.2f,%.2f,%.4f\n", BACKEND, datos, bitsFiltro[b],
+             ns[1], ns[0], ns[2], falsosPositivos);
+      fflush(stdout);
+    }
+    tablahash_destruir(tabla);
+    free(claves);
+    for (int o = 0; o < 3; o++)
+      free(indices[o]);
+  }
+}
+#endif
+
+#ifdef CON_CACHE
+/**
+ * Comprueba que al insertar en una cache llena, con todas las entradas
+ * usadas, se desaloja la mas vieja y no la recien insertada: con CLOCK la
+ * manecilla les quita la marca a todas y no debe detenerse en la nueva.
+ */
+static void comprobar_cache(PoliticaCache politica) {
+  Cache cache = cache_crear(3, 0, politica, copiar, comparar, destruir,
+                            hash_entero, NULL);
+  for (int k = 1; k <= 3; k++)
+    cache_insertar(cache, &k);
+  for (int k = 1; k <= 3; k++)
+    cache_buscar(cache, &k);
+  int nueva = 4, vieja = 1;
+  cache_insertar(cache, &nueva);
+  if (cache_buscar(cache, &nueva) == NULL ||
+      cache_buscar(cache, &vieja) != NULL || cache_nelems(cache) != 3) {
+    fprintf(stderr, "%s: la cache %s desalojo mal\n", BACKEND,
+            (politica == CACHE_LRU) ? "lru" : "clock");
+    exit(1);
+  }
+  cache_destruir(cache);
+}
+
+/**
+ * Modo cache: recorre una traza de OPS_CACHE accesos con rangos de Zipf sobre
+ * n claves, buscando cada clave en la cache e insertandola si falta, con cada
+ * politica y con capacidades del 1%, 5% y 10% de las claves.
+ */
+static void medir_cache(unsigned n) {
+  const unsigned porcentajes[] = {1, 5, 10};
+  comprobar_cache(CACHE_LRU);
+  comprobar_cache(CACHE_CLOCK);
+  const char *nombresPoliticas[] = {"lru", "clock"};
+  int *traza = malloc(sizeof(int) * OPS_CACHE);
+  if (traza == NULL)
+    abort();
+  Zipf zipf = zipf_crear(n);
+  uint64_t estado = 0x2545F4914F6CDD1Du ^ n;
+  // Las claves mas frecuentes quedan dispersas y no en orden.
+  for (unsigned i = 0; i < OPS_CACHE; i++)
+    traza[i] = clave(UNIFORME, zipf_rango(&zipf, &estado), 0);
+
+  for (int p = 0; p < 2; p++)
+    for (size_t c = 0; c < sizeof(porcentajes) / sizeof(porcentajes[0]); c++) {
+      unsigned capacidad = (unsigned)((unsigned long)n * porcentajes[c] / 100);
+      Cache cache = cache_crear(capacidad, 0, (PoliticaCache)p, copiar,
+                                comparar, destruir, hash_entero, NULL);
+      double inicio = segundos();
+      for (unsigned i = 0; i < OPS_CACHE; i++)
+        if (cache_buscar(cache, &traza[i]) == NULL)
+          cache_insertar(cache, &traza[i]);
+      double tiempo = segundos() - inicio;
+      CacheEstadisticas estadisticas;
+      cache_estadisticas(cache, &estadisticas);
+      printf("%s,%s,%u,%u,%u,%.2f,%.4f,%lu\n", BACKEND, nombresPoliticas[p],
+             n, capacidad, OPS_CACHE, tiempo * 1e9 / OPS_CACHE,
+             (double)estadisticas.aciertos / OPS_CACHE, estadisticas.desalojos);
+      fflush(stdout);
+      cache_destruir(cache);
+    }
+  free(traza);
+}
+#endif
+
+#ifdef CON_CUCKOO
+/**
+ * Modo desalojos (solo cuckoo): llena una tabla de capacidad fija con la
+ * carga maxima en su tope, hasta que una insercion no encuentra lugar y la
+ * obliga a redimensionar. Por cada vigesimo de la capacidad informa el tiempo
+ * y los datos desplazados por insercion, y los sondeos de las busquedas
+ * exitosas; al final, la carga a la que fallo (0 si llego al tope sin
+ * fallar). Repite con capacidades de n / 256, n / 16 y n, porque las tablas
+ * chicas fallan antes.
+ */
+static void medir_desalojos(unsigned n) {
+  for (unsigned divisor = 256; divisor >= 1; divisor /= 16) {
+    TablaHashOpciones opciones = {0};
+    opciones.cargaMaxima = 1;
+    TablaHash tabla = tablahash_crear_con_opciones(
+        n / divisor, copiar, comparar, destruir, hash_entero, &opciones);
+    unsigned capacidad = (unsigned)tablahash_capacidad(tabla);
+    int *claves = malloc(sizeof(int) * capacidad);
+    unsigned *indices = malloc(sizeof(unsigned) * capacidad);
+    if (claves == NULL || indices == NULL)
+      abort();
+    uint64_t estado = 0x2545F4914F6CDD1Du ^ capacidad;
+    unsigned insertadas = 0;
+    for (int vigesimos = 1; vigesimos <= 20; vigesimos++) {
+      unsigned objetivo = (unsigned)((unsigned long)capacidad * vigesimos / 20);
+      unsigned long desplazados = tablahash_cuckoo_desplazamientos(tabla);
+      unsigned desde = insertadas;
+      double inicio = segundos();
+      for (; insertadas < objetivo && tablahash_capacidad(tabla) == (int)capacidad;
+           insertadas++) {
+        claves[insertadas] = clave(UNIFORME, insertadas, 0);
+        tablahash_insertar(tabla, &claves[insertadas]);
+      }
+      double tiempo = segundos() - inicio;
+      // El tramo en el que fallo una insercion incluye la redimension.
+      if (tablahash_capacidad(tabla) != (int)capacidad)
+        break;
+      // En las tablas chicas un vigesimo puede no llegar a un dato.
+      if (insertadas == desde)
+        continue;
+      for (unsigned i = 0; i < insertadas; i++)
+        indices[i] = aleatorio(&estado) % insertadas;
+      TablaHashEstadisticas antes, despues;
+      tablahash_estadisticas(tabla, &antes);
+      unsigned long ops;
+      buscar(tabla, claves, indices, insertadas, &ops);
+      tablahash_estadisticas(tabla, &despues);
+      printf("%s,%u,%.3f,insertar,%.2f,%.3f,%.2f\n", BACKEND, capacidad,
+             (double)insertadas / capacidad, tiempo * 1e9 / (insertadas - desde),
+             (double)(tablahash_cuckoo_desplazamientos(tabla) - desplazados) /
+                 (insertadas - desde),
+             sondeos_medios(&antes, &despues, 1));
+    }
+    printf("%s,%u,%.3f,carga_maxima,0,0,0\n", BACKEND, capacidad,
+           tablahash_cuckoo_carga_maxima(tabla));
+    tablahash_destruir(tabla);
+    free(claves);
+    free(indices);
+  }
+}
+#endif
+
+/**
+ * Mediciones aparte de la principal, que se eligen con el primer argumento.
+ * Cada una imprime su propio CSV y recibe el numero de datos (o capacidad).
+ */
+typedef struct {
+  const char *nombre;
+  void (*medir)(unsigned n);
+  unsigned n;
+  const char *cabecera;
+} Modo;
+
+static const Modo modos[] = {
+    {"factores", medir_factores, 1u << 20,
+     "backend,factor,n,operacion,ns_op,sondeos_medio,sondeo_maximo,"
+     "encontrados"},
+    {"latencia", medir_latencia, 1u << 22,
+     "backend,pasos,bits_filtro,n,ns_op,p50_ns,p99_ns,p999_ns,maximo_ns"},
+    {"barrido", medir_barrido, 1u << 22,
+     "backend,capacidad,n,operacion,ns_op,sondeos_medio"},
+    {"churn", medir_churn, 1u << 20,
+     "backend,ops,n,ns_op,capacidad,borradas,desbordados,sondeo_maximo,"
+     "sondeos_acierto,sondeos_fallo"},
+#ifdef CON_FILTRO
+    {"filtro", medir_filtro, 1u << 22,
+     "backend,n,bits_dato,ns_acierto,ns_fallo,ns_mezcla,falsos_positivos"},
+#endif
+#ifdef CON_CACHE
+    {"cache", medir_cache, 1u << 20,
+     "backend,politica,n,capacidad,ops,ns_op,aciertos,desalojos"},
+#endif
+#ifdef CON_CUCKOO
+    {"desalojos", medir_desalojos, 1u << 20,
+     "backend,capacidad,factor,operacion,ns_op,desplazados_op,sondeos_medio"},
+#endif
+};
+
+/**
+ * Retorna el tamano de cache dado por sysconf, o el predeterminado si el
+ * sistema no lo informa.
+ */
+static long tamano_cache(int nombre, long predeterminado) {
+  long tam = sysconf(nombre);
+  return (tam > 0) ? tam : predeterminado;
+}
+
+/**
+ * Mide la carga con n datos en un proceso hijo.
+ */
+static void medir_aparte(Carga carga, const char *tamano, unsigned n) {
+  fflush(stdout);
+  pid_t hijo = fork();
+  if (hijo == 0) {
+    medir(carga, tamano, n);
+    fflush(stdout);
+    _exit(0);
+  }
+  int estado;
+  if (hijo < 0 || waitpid(hijo, &estado, 0) < 0 || !WIFEXITED(estado) ||
+      WEXITSTATUS(estado) != 0)
+    fprintf(stderr, "%s: fallo la medicion %s/%s\n", BACKEND,
+            nombresCargas[carga], tamano);
+}
+
+int main(int argc, char *argv[]) {
+  const char *nombres[4] = {"L1", "L2", "L3", "10xL3"};
+  unsigned tamanos[4];
+  int numTamanos = 4;
+  long l3 = tamano_cache(_SC_LEVEL3_CACHE_SIZE, 8l << 20);
+  tamanos[0] = tamano_cache(_SC_LEVEL1_DCACHE_SIZE, 32l << 10) / BYTES_POR_DATO;
+  tamanos[1] = tamano_cache(_SC_LEVEL2_CACHE_SIZE, 1l << 20) / BYTES_POR_DATO;
+  tamanos[2] = l3 / BYTES_POR_DATO;
+  tamanos[3] = 10 * l3 / BYTES_POR_DATO;
+
+  const Modo *modo = NULL;
+  for (size_t i = 0; argc > 1 && i < sizeof(modos) / sizeof(modos[0]); i++)
+    if (strcmp(argv[1], modos[i].nombre) == 0)
+      modo = &modos[i];
+  if (modo != NULL) {
+    unsigned n = modo->n;
+    for (int i = 2; i < argc; i++) {
+      if (strcmp(argv[i], "-c") == 0)
+        printf("%s\n", modo->cabecera);
+      else if (atol(argv[i]) > 0)
+        n = (unsigned)atol(argv[i]);
+    }
+    modo->medir(n);
+    return 0;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-c") == 0)
+      printf("backend,carga,tamano,n,operacion,ns_op,bytes_dato,rss_max_kb,"
+             "encontrados\n");
+    else if (atol(argv[i]) > 0) {
+      tamanos[0] = (unsigned)atol(argv[i]);
+      nombres[0] = "n";
+      numTamanos = 1;
+    } else {
+      // Un modo que este backend no tiene (p. ej. desalojos sin cuckoo).
+      fprintf(stderr, "%s: modo desconocido %s\n", BACKEND, argv[i]);
+      return 1;
+    }
+  }
+
+  for (int t = 0; t < numTamanos; t++)
+    for (Carga carga = 0; carga < NUM_CARGAS; carga++)
+      medir_aparte(carga, nombres[t], tamanos[t]);
+  return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * Banco de pruebas de escalabilidad de tablahashconc.h con varios hilos:
+ *
+ *   gcc -std=c11 -O2 -DNDEBUG -pthread bench_tablahashconc.c tablahashconc.c \
+ *       tablahashlp.c funcioneshash.c -o bench_tablahashconc
+ *   ./bench_tablahashconc [n] > resultados.csv
+ *
+ * Llena la tabla con n enteros (2^20 si no se indica) y despues cada hilo
+ * hace operaciones al azar sobre claves de 0 a 2n - 1: busquedas, o con la
+ * probabilidad restante inserciones y eliminaciones por partes iguales (asi
+ * la tabla se mantiene alrededor de n datos). Se mide con 1, 2, 4... hasta 64
+ * hilos, con 99%, 90% y 50% de busquedas, y con un solo fragmento (todas las
+ * operaciones pasan por el mismo candado) o con FRAGMENTOS. Imprime una linea
+ * CSV por combinacion:
+ *   fragmentos,hilos,lecturas,n,ops,ns_op,mops
+ * ns_op es el tiempo total dividido por las operaciones de todos los hilos, y
+ * mops los millones de operaciones por segundo. Con mas hilos que
+ * procesadores el rendimiento deja de crecer: los hilos de mas solo miden el
+ * costo de esperar los candados.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "funcioneshash.h"
+#include "tablahashconc.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FRAGMENTOS 64
+#define OPS_POR_HILO (1u << 20)
+#define MAX_HILOS 64
+
+static void *copiar(void *dato) {
+  int *copia = malloc(sizeof(int));
+  if (copia == NULL)
+    abort();
+  *copia = *(int *)dato;
+  return copia;
+}
+
+static int comparar(void *dato1, void *dato2) {
+  int a = *(int *)dato1, b = *(int *)dato2;
+  return (a > b) - (a < b);
+}
+
+static void destruir(void *dato) { free(dato); }
+
+/**
+ * Generador pseudoaleatorio (splitmix64).
+ */
+static uint64_t aleatorio(uint64_t *estado) {
+  uint64_t z = (*estado += 0x9E3779B97F4A7C15u);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Retorna los segundos de un reloj monotono.
+ */
+static double segundos(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Trabajo de un hilo: la tabla compartida, el porcentaje de busquedas y la
+ * semilla propia del hilo.
+ */
+typedef struct {
+  TablaHashConc tabla;
+  unsigned n;
+  unsigned lecturas;
+  uint64_t semilla;
+  pthread_barrier_t *largada;
+} Trabajo;
+
+static void *trabajar(void *extra) {
+  Trabajo *trabajo = extra;
+  uint64_t estado = trabajo->semilla;
+  pthread_barrier_wait(trabajo->largada);
+  for (unsigned i = 0; i < OPS_POR_HILO; i++) {
+    uint64_t r = aleatorio(&estado);
+    int k = (int)((r >> 8) % (2ull * trabajo->n));
+    unsigned tipo = (unsigned)(r & 0xFF) * 100 / 256;
+    if (tipo < trabajo->lecturas)
+      free(tablahashconc_buscar(trabajo->tabla, &k));
+    else if ((tipo - trabajo->lecturas) % 2 == 0)
+      tablahashconc_insertar(trabajo->tabla, &k);
+    else
+      tablahashconc_eliminar(trabajo->tabla, &k);
+  }
+  return NULL;
+}
+
+/**
+ * Mide una combinacion de fragmentos, hilos y porcentaje de busquedas.
+ */
+static void medir(unsigned fragmentos, int hilos, unsigned lecturas,
+                  unsigned n) {
+  TablaHashConc tabla = tablahashconc_crear(fragmentos, 16, copiar, comparar,
+                                            destruir, hash_entero);
+  for (unsigned i = 0; i < 2 * n; i += 2) {
+    int k = (int)i;
+    tablahashconc_insertar(tabla, &k);
+  }
+
+  pthread_t ids[MAX_HILOS];
+  Trabajo trabajos[MAX_HILOS];
+  pthread_barrier_t largada;
+  pthread_barrier_init(&largada, NULL, hilos + 1);
+  for (int h = 0; h < hilos; h++) {
+    trabajos[h] = (Trabajo){tabla, n, lecturas, 0x2545F4914F6CDD1Du * (h + 1),
+                            &largada};
+    if (pthread_create(&ids[h], NULL, trabajar, &trabajos[h]) != 0)
+      abort();
+  }
+  pthread_barrier_wait(&largada);
+  double inicio = segundos();
+  for (int h = 0; h < hilos; h++)
+    pthread_join(ids[h], NULL);
+  double tiempo = segundos() - inicio;
+  pthread_barrier_destroy(&largada);
+
+  unsigned long ops = (unsigned long)hilos * OPS_POR_HILO;
+  printf("%u,%d,%u,%u,%lu,%.2f,%.2f\n", fragmentos, hilos, lecturas, n, ops,
+         tiempo * 1e9 / ops, ops / tiempo / 1e6);
+  fflush(stdout);
+  tablahashconc_destruir(tabla);
+}
+
+int main(int argc, char *argv[]) {
+  unsigned n = (argc > 1 && atol(argv[1]) > 0) ? (unsigned)atol(argv[1])
+                                               : 1u << 20;
+  const unsigned lecturas[] = {99, 90, 50};
+  const unsigned fragmentos[] = {1, FRAGMENTOS};
+  for (int f = 0; f < 2; f++)
+    for (int l = 0; l < 3; l++)
+      for (int hilos = 1; hilos <= MAX_HILOS; hilos *= 2)
+        medir(fragmentos[f], hilos, lecturas[l], n);
+  return 0;
+}
@@ -0,0 +1,255 @@
+#include "cache.h"
+#include <assert.h>
+#include <stdlib.h>
+#define CAPACIDAD_INICIAL 16
+
+/**
+ * Entrada de la cache: el dato, los enlaces de la lista (ant hacia la entrada
+ * mas nueva y sig hacia la mas vieja), la memoria que se le cuenta y la marca
+ * de CLOCK. La tabla hash guarda punteros a las entradas, asi que cada una
+ * lleva tambien un puntero a su cache para llegar a las funciones del
+ * usuario.
+ */
+typedef struct _EntradaCache {
+  void *dato;
+  struct _EntradaCache *ant, *sig;
+  size_t memoria;
+  int marcada;
+  Cache cache;
+} EntradaCache;
+
+/**
+ * Estructura principal que representa la cache.
+ * primera es la entrada mas nueva y ultima la mas vieja. Con CACHE_CLOCK,
+ * manecilla es la proxima entrada a revisar al desalojar (NULL equivale a
+ * volver a empezar desde ultima).
+ */
+struct _Cache {
+  TablaHash tabla;
+  EntradaCache *primera, *ultima;
+  EntradaCache *manecilla;
+  unsigned maxDatos;
+  size_t maxMemoria;
+  size_t memoria;
+  PoliticaCache politica;
+  FuncionCopiadora copia;
+  FuncionComparadora comp;
+  FuncionDestructora destr;
+  FuncionHash hash;
+  FuncionTamano tam;
+  CacheEstadisticas estadisticas;
+};
+
+/**
+ * Quita la entrada de la lista.
+ */
+static void cache_lista_quitar(Cache cache, EntradaCache *entrada) {
+  if (cache->manecilla == entrada)
+    cache->manecilla = entrada->ant;
+  if (entrada->ant != NULL)
+    entrada->ant->sig = entrada->sig;
+  else
+    cache->primera = entrada->sig;
+  if (entrada->sig != NULL)
+    entrada->sig->ant = entrada->ant;
+  else
+    cache->ultima = entrada->ant;
+}
+
+/**
+ * Agrega la entrada al frente de la lista.
+ */
+static void cache_lista_agregar(Cache cache, EntradaCache *entrada) {
+  entrada->ant = NULL;
+  entrada->sig = cache->primera;
+  if (cache->primera != NULL)
+    cache->primera->ant = entrada;
+  else
+    cache->ultima = entrada;
+  cache->primera = entrada;
+}
+
+/**
+ * Funciones de la tabla hash sobre las entradas. La tabla no copia las
+ * entradas (las crea la cache), y al destruir una la quita de la lista.
+ */
+static void *entrada_copiar(void *entrada) { return entrada; }
+
+static int entrada_comparar(void *entrada1, void *entrada2) {
+  EntradaCache *e1 = entrada1, *e2 = entrada2;
+  return e1->cache->comp(e1->dato, e2->dato);
+}
+
+static unsigned entrada_hash(void *entrada) {
+  EntradaCache *e = entrada;
+  return e->cache->hash(e->dato);
+}
+
+static void entrada_destruir(void *entrada) {
+  EntradaCache *e = entrada;
+  Cache cache = e->cache;
+  cache_lista_quitar(cache, e);
+  cache->memoria -= e->memoria;
+  cache->destr(e->dato);
+  free(e);
+}
+
+/**
+ * Crea una cache vacia.
+ */
+Cache cache_crear(unsigned maxDatos, size_t maxMemoria, PoliticaCache politica,
+                  FuncionCopiadora copia, FuncionComparadora comp,
+                  FuncionDestructora destr, FuncionHash hash, FuncionTamano tam) {
+  Cache cache = malloc(sizeof(struct _Cache));
+  assert(cache != NULL);
+  cache->tabla = tablahash_crear(CAPACIDAD_INICIAL, entrada_copiar,
+                                 entrada_comparar, entrada_destruir, entrada_hash);
+  if (maxDatos > 0)
+    tablahash_reservar(cache->tabla, maxDatos);
+  cache->primera = cache->ultima = cache->manecilla = NULL;
+  cache->maxDatos = maxDatos;
+  cache->maxMemoria = maxMemoria;
+  cache->memoria = 0;
+  cache->politica = politica;
+  cache->copia = copia;
+  cache->comp = comp;
+  cache->destr = destr;
+  cache->hash = hash;
+  cache->tam = tam;
+  cache->estadisticas = (CacheEstadisticas){0, 0, 0};
+  return cache;
+}
+
+/**
+ * Destruye la cache y sus datos.
+ */
+void cache_destruir(Cache cache) {
+  tablahash_destruir(cache->tabla);
+  free(cache);
+}
+
+/**
+ * Retorna el numero de datos de la cache.
+ */
+int cache_nelems(Cache cache) { return tablahash_nelems(cache->tabla); }
+
+/**
+ * Retorna la memoria que ocupan los datos de la cache.
+ */
+size_t cache_memoria(Cache cache) { return cache->memoria; }
+
+/**
+ * Retorna la entrada de la cache cuyo dato coincide con el dato dado, o NULL.
+ */
+static EntradaCache *cache_entrada(Cache cache, void *dato) {
+  EntradaCache sonda = {dato, NULL, NULL, 0, 0, cache};
+  return tablahash_buscar(cache->tabla, &sonda);
+}
+
+/**
+ * Registra un uso de la entrada, de acuerdo a la politica.
+ */
+static void cache_usar(Cache cache, EntradaCache *entrada) {
+  if (cache->politica == CACHE_LRU) {
+    cache_lista_quitar(cache, entrada);
+    cache_lista_agregar(cache, entrada);
+  }
+  else
+    entrada->marcada = 1;
+}
+
+/**
+ * Retorna el dato de la cache que coincida con el dato dado, o NULL.
+ */
+void *cache_buscar(Cache cache, void *dato) {
+  EntradaCache *entrada = cache_entrada(cache, dato);
+  if (entrada == NULL) {
+    cache->estadisticas.fallos++;
+    return NULL;
+  }
+  cache->estadisticas.aciertos++;
+  cache_usar(cache, entrada);
+  return entrada->dato;
+}
+
+/**
+ * Desaloja un dato: con CACHE_LRU el menos usado recientemente, y con
+ * CACHE_CLOCK el primero sin marcar a partir de la manecilla. Como la
+ * manecilla le quita la marca a cada entrada que saltea, a lo sumo da una
+ * vuelta entera antes de encontrarlo. La entrada protegida (la que se esta
+ * insertando) solo se desaloja si es la unica; con CACHE_LRU nunca es la
+ * ultima salvo en ese caso, porque se acaba de agregar o usar.
+ */
+static void cache_desalojar(Cache cache, EntradaCache *protegida) {
+  EntradaCache *victima = cache->ultima;
+  if (cache->politica == CACHE_CLOCK && cache->primera != cache->ultima) {
+    for (;;) {
+      if (cache->manecilla == NULL)
+        cache->manecilla = cache->ultima;
+      if (cache->manecilla != protegida) {
+        if (!cache->manecilla->marcada)
+          break;
+        cache->manecilla->marcada = 0;
+      }
+      cache->manecilla = cache->manecilla->ant;
+    }
+    victima = cache->manecilla;
+  }
+  cache->estadisticas.desalojos++;
+  // La tabla destruye la entrada y la quita de la lista.
+  tablahash_eliminar(cache->tabla, victima);
+}
+
+/**
+ * Retorna 1 si la cache supera alguno de sus limites.
+ */
+static int cache_excedida(Cache cache) {
+  return (cache->maxDatos > 0 && cache_nelems(cache) > (int)cache->maxDatos) ||
+         (cache->maxMemoria > 0 && cache->memoria > cache->maxMemoria);
+}
+
+/**
+ * Inserta una copia del dato en la cache, o reemplaza el que coincida, y
+ * desaloja datos hasta volver a respetar los limites.
+ */
+void cache_insertar(Cache cache, void *dato) {
+  EntradaCache *entrada = cache_entrada(cache, dato);
+  int nueva = (entrada == NULL);
+  if (!nueva) {
+    // La entrada sigue en la tabla: solo cambia su dato, con la misma clave.
+    cache->memoria -= entrada->memoria;
+    cache->destr(entrada->dato);
+    cache_usar(cache, entrada);
+  }
+  else {
+    entrada = malloc(sizeof(EntradaCache));
+    assert(entrada != NULL);
+    entrada->marcada = 0;
+    entrada->cache = cache;
+    cache_lista_agregar(cache, entrada);
+  }
+  entrada->dato = cache->copia(dato);
+  entrada->memoria = sizeof(EntradaCache) +
+                     ((cache->tam != NULL) ? cache->tam(entrada->dato) : 0);
+  cache->memoria += entrada->memoria;
+  if (nueva)
+    tablahash_insertar(cache->tabla, entrada);
+
+  while (cache_excedida(cache) && cache_nelems(cache) > 0)
+    cache_desalojar(cache, entrada);
+}
+
+/**
+ * Elimina el dato de la cache que coincida con el dato dado.
+ */
+void cache_eliminar(Cache cache, void *dato) {
+  EntradaCache sonda = {dato, NULL, NULL, 0, 0, cache};
+  tablahash_eliminar(cache->tabla, &sonda);
+}
+
+/**
+ * Completa estadisticas con los contadores de la cache.
+ */
+void cache_estadisticas(Cache cache, CacheEstadisticas *estadisticas) {
+  *estadisticas = cache->estadisticas;
+}
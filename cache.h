@@ -0,0 +1,84 @@
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include "tablahash.h"
+#include <stddef.h>
+
+/**
+ * Cache acotada sobre una TablaHash. Cada dato se guarda en una entrada que
+ * lleva embebidos los enlaces de una lista doblemente enlazada (de la entrada
+ * mas nueva a la mas vieja), asi que buscar, insertar y desalojar cuestan
+ * O(1) sin recorrer la cache.
+ * Con CACHE_LRU cada acierto mueve la entrada al frente de la lista y se
+ * desaloja la del final. Con CACHE_CLOCK un acierto solo marca la entrada, sin
+ * tocar la lista: una manecilla recorre las entradas de la mas vieja a la mas
+ * nueva dando una segunda oportunidad a las marcadas (les quita la marca) y
+ * desaloja la primera sin marcar. En las dos, el dato que se inserta no se
+ * desaloja para hacerse lugar a si mismo (salvo que solo el supere maxMemoria).
+ * La implementacion de tablahash con la que se enlace debe manejar colisiones
+ * (tablahashsc.c no sirve, porque descarta datos).
+ */
+typedef struct _Cache *Cache;
+
+typedef enum {
+  CACHE_LRU,
+  CACHE_CLOCK
+} PoliticaCache;
+
+typedef struct {
+  unsigned long aciertos;
+  unsigned long fallos;
+  unsigned long desalojos;
+} CacheEstadisticas;
+
+/**
+ * Crea una cache vacia que guarda a lo sumo maxDatos datos y maxMemoria bytes
+ * (0 para no limitar). La memoria de cada dato es tam(dato) mas lo que ocupa
+ * su entrada; si tam es NULL, solo se cuenta la entrada. Las funciones copia,
+ * comp, destr y hash son las de la tabla hash.
+ */
+Cache cache_crear(unsigned maxDatos, size_t maxMemoria, PoliticaCache politica,
+                  FuncionCopiadora copia, FuncionComparadora comp,
+                  FuncionDestructora destr, FuncionHash hash, FuncionTamano tam);
+
+/**
+ * Destruye la cache y sus datos.
+ */
+void cache_destruir(Cache cache);
+
+/**
+ * Retorna el numero de datos de la cache.
+ */
+int cache_nelems(Cache cache);
+
+/**
+ * Retorna la memoria que ocupan los datos de la cache, segun se cuenta para
+ * maxMemoria.
+ */
+size_t cache_memoria(Cache cache);
+
+/**
+ * Retorna el dato de la cache que coincida con el dato dado, o NULL si no se
+ * encuentra, y lo cuenta como acierto o fallo. El dato sigue siendo de la
+ * cache: puede desalojarse en la siguiente insercion.
+ */
+void *cache_buscar(Cache cache, void *dato);
+
+/**
+ * Inserta una copia del dato en la cache, o reemplaza el dato que coincida si
+ * ya se encontraba, y desaloja datos hasta volver a respetar los limites.
+ */
+void cache_insertar(Cache cache, void *dato);
+
+/**
+ * Elimina el dato de la cache que coincida con el dato dado.
+ */
+void cache_eliminar(Cache cache, void *dato);
+
+/**
+ * Completa estadisticas con los aciertos, fallos y desalojos desde la
+ * creacion de la cache.
+ */
+void cache_estadisticas(Cache cache, CacheEstadisticas *estadisticas);
+
+#endif /* __CACHE_H__ */
@@ -0,0 +1,132 @@
+#ifndef __FILTROBLOOM_H__
+#define __FILTROBLOOM_H__
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Filtro de Bloom por bloques. Cada dato se representa por su hash, y todos
+ * sus bits caen en un mismo bloque de 64 bytes (una linea de cache), asi que
+ * agregar o consultar un dato lee una sola linea. Responde "seguro que no
+ * esta" o "puede estar"; no permite quitar datos, por eso quien lo usa debe
+ * vaciarlo y volver a agregar los datos cuando hace falta.
+ *
+ * Esta definido entero en el encabezado, como tablahashcontadores.h, para que
+ * quien lo use no tenga que enlazar otro archivo.
+ */
+#define FILTROBLOOM_TAM_BLOQUE 64
+#define FILTROBLOOM_PALABRAS (FILTROBLOOM_TAM_BLOQUE / sizeof(uint64_t))
+
+/**
+ * Bloque del filtro: una linea de cache con FILTROBLOOM_PALABRAS palabras de
+ * 64 bits. Cada dato enciende un bit en cada palabra del bloque.
+ */
+typedef struct {
+  uint64_t palabras[FILTROBLOOM_PALABRAS];
+} BloqueFiltro;
+
+/**
+ * bloques apunta al primer bloque alineado dentro de memoria, que es la
+ * reserva original (la que se libera).
+ */
+struct _FiltroBloom {
+  BloqueFiltro *bloques;
+  void *memoria;
+  unsigned numBloques;
+};
+
+typedef struct _FiltroBloom *FiltroBloom;
+
+/**
+ * Multiplicadores impares con los que se elige el bit de cada palabra a
+ * partir del hash (los mismos del filtro por bloques de Parquet).
+ */
+static const uint32_t FILTROBLOOM_SALES[FILTROBLOOM_PALABRAS] = {
+    0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+    0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+
+/**
+ * Retorna el bloque que le corresponde al hash. El hash se mezcla antes de
+ * reducirlo, para que el bloque no dependa de los mismos bits que eligen la
+ * casilla en la tabla.
+ */
+static inline BloqueFiltro *filtrobloom_bloque(FiltroBloom filtro,
+                                               unsigned hash) {
+  uint32_t mezcla = (uint32_t)hash * 0x9E3779B1u;
+  mezcla ^= mezcla >> 15;
+  return &filtro->bloques[((uint64_t)mezcla * filtro->numBloques) >> 32];
+}
+
+/**
+ * Vacia el filtro.
+ */
+static inline void filtrobloom_vaciar(FiltroBloom filtro) {
+  memset(filtro->bloques, 0, sizeof(BloqueFiltro) * filtro->numBloques);
+}
+
+/**
+ * Crea un filtro vacio con lugar para numDatos datos, usando bitsPorDato bits
+ * por dato (con 10 bits por dato la tasa de falsos positivos ronda el 1%).
+ * Los bloques se piden con calloc, asi que crear un filtro grande no recorre
+ * su memoria: las paginas se ponen en cero a medida que se usan.
+ */
+static inline FiltroBloom filtrobloom_crear(unsigned numDatos,
+                                            unsigned bitsPorDato) {
+  FiltroBloom filtro = malloc(sizeof(struct _FiltroBloom));
+  assert(filtro != NULL);
+  uint64_t bits = (uint64_t)numDatos * bitsPorDato;
+  filtro->numBloques = (bits + FILTROBLOOM_TAM_BLOQUE * 8 - 1) /
+                       (FILTROBLOOM_TAM_BLOQUE * 8);
+  if (filtro->numBloques == 0)
+    filtro->numBloques = 1;
+  // Un bloque de mas para poder alinear el primero a una linea de cache.
+  filtro->memoria = calloc(filtro->numBloques + 1, sizeof(BloqueFiltro));
+  assert(filtro->memoria != NULL);
+  uintptr_t dir = (uintptr_t)filtro->memoria;
+  filtro->bloques = (BloqueFiltro *)((dir + FILTROBLOOM_TAM_BLOQUE - 1) &
+                                     ~(uintptr_t)(FILTROBLOOM_TAM_BLOQUE - 1));
+  return filtro;
+}
+
+/**
+ * Destruye el filtro.
+ */
+static inline void filtrobloom_destruir(FiltroBloom filtro) {
+  free(filtro->memoria);
+  free(filtro);
+}
+
+/**
+ * Agrega al filtro un dato con el hash dado.
+ */
+static inline void filtrobloom_agregar(FiltroBloom filtro, unsigned hash) {
+  BloqueFiltro *bloque = filtrobloom_bloque(filtro, hash);
+  for (unsigned i = 0; i < FILTROBLOOM_PALABRAS; ++i)
+    bloque->palabras[i] |=
+        (uint64_t)1 << (((uint32_t)hash * FILTROBLOOM_SALES[i]) >> 26);
+}
+
+/**
+ * Retorna 0 si ningun dato agregado tiene el hash dado, y 1 si puede que
+ * alguno lo tenga.
+ */
+static inline int filtrobloom_puede_contener(FiltroBloom filtro,
+                                             unsigned hash) {
+  const BloqueFiltro *bloque = filtrobloom_bloque(filtro, hash);
+  uint64_t faltan = 0;
+  for (unsigned i = 0; i < FILTROBLOOM_PALABRAS; ++i)
+    faltan |= ~bloque->palabras[i] &
+              ((uint64_t)1 << (((uint32_t)hash * FILTROBLOOM_SALES[i]) >> 26));
+  return faltan == 0;
+}
+
+/**
+ * Adelanta la carga del bloque que corresponde al hash dado.
+ */
+static inline void filtrobloom_adelantar(FiltroBloom filtro, unsigned hash) {
+  __builtin_prefetch(filtrobloom_bloque(filtro, hash));
+}
+
+#endif /* __FILTROBLOOM_H__ */
@@ -0,0 +1,215 @@
+#include "funcioneshash.h"
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+/**
+ * Las entradas de hasta LARGO_CORTO bytes usan una mezcla con multiplicaciones
+ * de 64x64 -> 128 bits, en la linea de wyhash. Las mas largas acumulan bloques
+ * de TAM_FRANJA bytes en 8 carriles de 64 bits, en la linea de XXH3, y mezclan
+ * los carriles cada FRANJAS_POR_BLOQUE bloques.
+ */
+#define LARGO_CORTO 256
+#define TAM_FRANJA 64
+#define FRANJAS_POR_BLOQUE 16
+#define PRIMO32 0x9E3779B1u
+
+static const uint64_t secreto[FRANJAS_POR_BLOQUE + 8] = {
+  0x2cb0f69f4abea221ull, 0x9417034723148989ull, 0xdd555950609dfe03ull,
+  0xdbafb150deb12800ull, 0x7e789b2e6c442cb6ull, 0xf41e5636c7e4f8c4ull,
+  0x0959d150f8fba7e4ull, 0xa97316f13cdb9eeaull, 0x74cd8258f9520068ull,
+  0x55c74a62e116868bull, 0xd2f4c799a2023cbdull, 0xdf98cb79a37b51b9ull,
+  0x396f5885524f3905ull, 0xaf1d56386ca3b276ull, 0xa9ffbe6b5104e85aull,
+  0x6bd0c51b9fd533b3ull, 0x980ce91c50ab4b56ull, 0x28ac395780fe62c5ull,
+  0x768912e3a6bcedc7ull, 0x50b3e8c9332c7c88ull, 0xce3bbfe520bd47daull,
+  0xcba6c8e8e0bb7c4full, 0xbf194db8434a346dull, 0x7d8f2a7b60416d7full,
+};
+
+/**
+ * Lectura de 8, 4 y 1 a 3 bytes sin alineacion.
+ */
+static uint64_t leer64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+static uint64_t leer32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+static uint64_t leer_poco(const uint8_t *p, size_t largo) {
+  return ((uint64_t)p[0] << 16) | ((uint64_t)p[largo >> 1] << 8) | p[largo - 1];
+}
+
+/**
+ * Multiplica a y b en 128 bits y retorna la mitad alta xor la baja.
+ */
+static uint64_t mezclar(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 r = (unsigned __int128)a * b;
+  return (uint64_t)(r >> 64) ^ (uint64_t)r;
+#else
+  uint64_t ha = a >> 32, la = (uint32_t)a, hb = b >> 32, lb = (uint32_t)b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32);
+  uint64_t c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+  return hi ^ lo;
+#endif
+}
+
+/**
+ * Retorna el hash de 64 bits de un entero de 64 bits.
+ */
+uint64_t hash_u64(uint64_t x) {
+  return mezclar(x ^ secreto[0], secreto[1] ^ 0x9E3779B97F4A7C15ull);
+}
+
+/**
+ * Hash de entradas cortas (o de la cola de una larga).
+ */
+static uint64_t hash_corto(const uint8_t *p, size_t largo, uint64_t semilla) {
+  uint64_t a, b;
+  semilla ^= mezclar(semilla ^ secreto[0], secreto[1]);
+  if (largo <= 16) {
+    if (largo >= 4) {
+      a = (leer32(p) << 32) | leer32(p + ((largo >> 3) << 2));
+      b = (leer32(p + largo - 4) << 32) |
+          leer32(p + largo - 4 - ((largo >> 3) << 2));
+    }
+    else if (largo > 0) {
+      a = leer_poco(p, largo);
+      b = 0;
+    }
+    else
+      a = b = 0;
+  }
+  else {
+    size_t resto = largo;
+    if (resto > 48) {
+      uint64_t s1 = semilla, s2 = semilla;
+      do {
+        semilla = mezclar(leer64(p) ^ secreto[1], leer64(p + 8) ^ semilla);
+        s1 = mezclar(leer64(p + 16) ^ secreto[2], leer64(p + 24) ^ s1);
+        s2 = mezclar(leer64(p + 32) ^ secreto[3], leer64(p + 40) ^ s2);
+        p += 48;
+        resto -= 48;
+      } while (resto > 48);
+      semilla ^= s1 ^ s2;
+    }
+    while (resto > 16) {
+      semilla = mezclar(leer64(p) ^ secreto[1], leer64(p + 8) ^ semilla);
+      p += 16;
+      resto -= 16;
+    }
+    a = leer64(p + resto - 16);
+    b = leer64(p + resto - 8);
+  }
+  a ^= secreto[1];
+  b ^= semilla;
+  uint64_t r = mezclar(a, b);
+  return mezclar(r ^ secreto[0] ^ largo, b ^ secreto[1]);
+}
+
+/**
+ * Suma una franja de TAM_FRANJA bytes a los 8 carriles. clave apunta a los 8
+ * valores del secreto que le tocan a la franja segun su posicion en el bloque.
+ */
+static void acumular_franja(uint64_t *acc, const uint8_t *p,
+                            const uint64_t *clave) {
+#ifdef __SSE2__
+  for (unsigned i = 0; i < 4; ++i) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(acc + 2 * i));
+    __m128i d = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+    __m128i k = _mm_xor_si128(d, _mm_loadu_si128((const __m128i *)(clave + 2 * i)));
+    // Producto de la mitad baja por la alta de cada carril de 64 bits.
+    __m128i producto = _mm_mul_epu32(k, _mm_srli_epi64(k, 32));
+    // Cada carril suma tambien el dato del carril vecino.
+    __m128i vecino = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+    a = _mm_add_epi64(a, _mm_add_epi64(producto, vecino));
+    _mm_storeu_si128((__m128i *)(acc + 2 * i), a);
+  }
+#else
+  for (unsigned i = 0; i < 8; ++i) {
+    uint64_t d = leer64(p + 8 * i);
+    uint64_t k = d ^ clave[i];
+    acc[i ^ 1] += d;
+    acc[i] += (k & 0xFFFFFFFFu) * (k >> 32);
+  }
+#endif
+}
+
+/**
+ * Mezcla los carriles al final de cada bloque, para que el orden de los
+ * bloques importe.
+ */
+static void revolver(uint64_t *acc) {
+  for (unsigned i = 0; i < 8; ++i) {
+    acc[i] ^= acc[i] >> 47;
+    acc[i] ^= secreto[FRANJAS_POR_BLOQUE + i];
+    acc[i] *= PRIMO32;
+  }
+}
+
+/**
+ * Hash de entradas largas.
+ */
+static uint64_t hash_largo(const uint8_t *p, size_t largo, uint64_t semilla) {
+  uint64_t acc[8];
+  for (unsigned i = 0; i < 8; ++i)
+    acc[i] = secreto[i] ^ semilla;
+
+  size_t franjas = largo / TAM_FRANJA;
+  for (size_t n = 0; n < franjas; ++n) {
+    acumular_franja(acc, p + n * TAM_FRANJA, &secreto[n % FRANJAS_POR_BLOQUE]);
+    if (n % FRANJAS_POR_BLOQUE == FRANJAS_POR_BLOQUE - 1)
+      revolver(acc);
+  }
+
+  uint64_t h = largo * 0x9E3779B97F4A7C15ull;
+  for (unsigned i = 0; i < 8; i += 2)
+    h += mezclar(acc[i] ^ secreto[i + 8], acc[i + 1] ^ secreto[i + 9]);
+  // Los bytes que no completan una franja se mezclan con el hash corto.
+  size_t resto = largo % TAM_FRANJA;
+  return hash_corto(p + largo - resto, resto, h);
+}
+
+/**
+ * Retorna el hash de 64 bits de los largo bytes apuntados por datos.
+ */
+uint64_t hash_bytes(const void *datos, size_t largo, uint64_t semilla) {
+  const uint8_t *p = datos;
+  if (largo <= LARGO_CORTO)
+    return hash_corto(p, largo, semilla);
+  return hash_largo(p, largo, semilla);
+}
+
+/**
+ * Reduce un hash de 64 bits a los 32 de FuncionHash.
+ */
+static unsigned plegar(uint64_t h) { return (unsigned)(h ^ (h >> 32)); }
+
+/**
+ * Hash de un int.
+ */
+unsigned hash_entero(void *dato) {
+  return plegar(hash_u64((uint64_t)(unsigned)*(int *)dato));
+}
+
+/**
+ * Hash del valor del puntero.
+ */
+unsigned hash_puntero(void *dato) {
+  return plegar(hash_u64((uint64_t)(uintptr_t)dato));
+}
+
+/**
+ * Hash de una cadena terminada en '\0'.
+ */
+unsigned hash_cadena(void *dato) {
+  const char *cadena = dato;
+  return plegar(hash_bytes(cadena, strlen(cadena), 0));
+}
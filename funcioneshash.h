@@ -0,0 +1,44 @@
+#ifndef __FUNCIONESHASH_H__
+#define __FUNCIONESHASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Funciones de hash rapidas y bien distribuidas para usar con las tablas hash.
+ * Todas dependen de todos los bits de la entrada, asi que se pueden reducir a
+ * la capacidad de la tabla con % o con una mascara sin que se agrupen.
+ */
+
+/**
+ * Retorna el hash de 64 bits de un entero de 64 bits.
+ */
+uint64_t hash_u64(uint64_t x);
+
+/**
+ * Retorna el hash de 64 bits de los largo bytes apuntados por datos, con la
+ * semilla dada. Las entradas largas se procesan de a bloques de 64 bytes con
+ * instrucciones SSE2 cuando estan disponibles.
+ */
+uint64_t hash_bytes(const void *datos, size_t largo, uint64_t semilla);
+
+/**
+ * Funciones listas para pasar como FuncionHash a tablahash_crear.
+ */
+
+/**
+ * Hash de un int, para datos que apuntan a un int.
+ */
+unsigned hash_entero(void *dato);
+
+/**
+ * Hash del valor del puntero (no de lo apuntado), para tablas de identidad.
+ */
+unsigned hash_puntero(void *dato);
+
+/**
+ * Hash de una cadena terminada en '\0', para datos que apuntan a un char.
+ */
+unsigned hash_cadena(void *dato);
+
+#endif /* __FUNCIONESHASH_H__ */
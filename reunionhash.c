@@ -0,0 +1,141 @@
+#include "reunionhash.h"
+#include "tablahashinline.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#define NINGUNA ((unsigned)-1)
+#define ADELANTO 8
+
+/**
+ * Fila de una particion: su posicion en la relacion y su hash.
+ */
+typedef struct {
+  unsigned fila;
+  unsigned hash;
+} Entrada;
+
+/**
+ * Retorna la particion de un hash. El hash se mezcla antes de reducirlo, para
+ * que la particion no dependa de los mismos bits que eligen la casilla en la
+ * tabla de la particion.
+ */
+static unsigned reunionhash_particion(unsigned hash, unsigned bitsParticion) {
+  unsigned mezcla = hash * 0x9E3779B1u;
+  mezcla ^= mezcla >> 15;
+  return mezcla & ((1u << bitsParticion) - 1);
+}
+
+/**
+ * Calcula el hash de cada fila de la relacion y retorna las filas ordenadas
+ * por particion. En inicios (de numParticiones + 1 posiciones) guarda donde
+ * empieza cada particion.
+ */
+static Entrada *reunionhash_particionar(Relacion relacion, FuncionHash hash,
+                                        unsigned bitsParticion, size_t *inicios) {
+  unsigned numParticiones = 1u << bitsParticion;
+  assert(relacion.numFilas < NINGUNA);
+  Entrada *entradas = malloc(sizeof(Entrada) * (relacion.numFilas + 1));
+  assert(entradas != NULL);
+  unsigned *hashes = malloc(sizeof(unsigned) * (relacion.numFilas + 1));
+  assert(hashes != NULL);
+
+  // Primera pasada: hashes y tamano de cada particion.
+  memset(inicios, 0, sizeof(size_t) * (numParticiones + 1));
+  const char *fila = relacion.filas;
+  for (size_t i = 0; i < relacion.numFilas; i++, fila += relacion.tamFila) {
+    hashes[i] = hash((void *)fila);
+    inicios[reunionhash_particion(hashes[i], bitsParticion) + 1]++;
+  }
+  for (unsigned p = 0; p < numParticiones; p++)
+    inicios[p + 1] += inicios[p];
+
+  // Segunda pasada: cada fila va al final de su particion.
+  size_t *siguiente = malloc(sizeof(size_t) * numParticiones);
+  assert(siguiente != NULL);
+  memcpy(siguiente, inicios, sizeof(size_t) * numParticiones);
+  for (size_t i = 0; i < relacion.numFilas; i++) {
+    Entrada *entrada =
+        &entradas[siguiente[reunionhash_particion(hashes[i], bitsParticion)]++];
+    entrada->fila = i;
+    entrada->hash = hashes[i];
+  }
+  free(siguiente);
+  free(hashes);
+  return entradas;
+}
+
+/**
+ * Aplica visita a cada par de filas con la misma clave.
+ * Cada dato de la tabla de una particion es una clave seguida de la primera
+ * fila de construccion con esa clave; las demas se encadenan en siguiente.
+ */
+void reunionhash(Relacion construccion, Relacion sondeo, size_t tamClave,
+                 FuncionComparadora comp, FuncionHash hash,
+                 unsigned bitsParticion, FuncionVisitanteReunion visita,
+                 void *extra) {
+  assert(tamClave <= construccion.tamFila && tamClave <= sondeo.tamFila);
+  unsigned numParticiones = 1u << bitsParticion;
+  size_t *iniciosC = malloc(sizeof(size_t) * (numParticiones + 1));
+  size_t *iniciosS = malloc(sizeof(size_t) * (numParticiones + 1));
+  assert(iniciosC != NULL && iniciosS != NULL);
+  Entrada *entradasC =
+      reunionhash_particionar(construccion, hash, bitsParticion, iniciosC);
+  Entrada *entradasS = reunionhash_particionar(sondeo, hash, bitsParticion, iniciosS);
+
+  size_t desplazamiento =
+      (tamClave + sizeof(unsigned) - 1) / sizeof(unsigned) * sizeof(unsigned);
+  size_t tamDato = desplazamiento + sizeof(unsigned);
+  char *nuevo = malloc(tamDato);
+  assert(nuevo != NULL);
+  unsigned *siguiente = malloc(sizeof(unsigned) * (construccion.numFilas + 1));
+  assert(siguiente != NULL);
+  const char *filasC = construccion.filas;
+  const char *filasS = sondeo.filas;
+
+  for (unsigned p = 0; p < numParticiones; p++) {
+    if (iniciosC[p] == iniciosC[p + 1] || iniciosS[p] == iniciosS[p + 1])
+      continue;
+    TablaHashInline tabla = tablahashinline_crear(
+        (iniciosC[p + 1] - iniciosC[p]) * 2, tamDato, tamClave, comp, hash);
+
+    // Construccion: la fila pasa a ser la primera de su clave.
+    for (size_t i = iniciosC[p]; i < iniciosC[p + 1]; i++) {
+      unsigned fila = entradasC[i].fila;
+      memcpy(nuevo, filasC + (size_t)fila * construccion.tamFila, tamClave);
+      memcpy(nuevo + desplazamiento, &fila, sizeof(unsigned));
+      int insertado;
+      char *dato = tablahashinline_buscar_o_insertar_hash(tabla, nuevo,
+                                                          entradasC[i].hash,
+                                                          &insertado);
+      if (insertado)
+        siguiente[fila] = NINGUNA;
+      else {
+        memcpy(&siguiente[fila], dato + desplazamiento, sizeof(unsigned));
+        memcpy(dato + desplazamiento, &fila, sizeof(unsigned));
+      }
+    }
+
+    // Sondeo, adelantando la carga de la casilla de la fila ADELANTO lugares
+    // mas adelante.
+    for (size_t i = iniciosS[p]; i < iniciosS[p + 1]; i++) {
+      if (i + ADELANTO < iniciosS[p + 1])
+        tablahashinline_adelantar(tabla, entradasS[i + ADELANTO].hash);
+      const char *filaS = filasS + (size_t)entradasS[i].fila * sondeo.tamFila;
+      char *dato = tablahashinline_buscar_hash(tabla, filaS, entradasS[i].hash);
+      if (dato == NULL)
+        continue;
+      unsigned fila;
+      memcpy(&fila, dato + desplazamiento, sizeof(unsigned));
+      for (; fila != NINGUNA; fila = siguiente[fila])
+        visita(filasC + (size_t)fila * construccion.tamFila, filaS, extra);
+    }
+    tablahashinline_destruir(tabla);
+  }
+
+  free(siguiente);
+  free(nuevo);
+  free(entradasC);
+  free(entradasS);
+  free(iniciosC);
+  free(iniciosS);
+}
@@ -0,0 +1,43 @@
+#ifndef __REUNIONHASH_H__
+#define __REUNIONHASH_H__
+
+#include "tablahash.h"
+#include <stddef.h>
+
+/**
+ * Reunion por igualdad de clave (hash join) de dos conjuntos de filas de
+ * tamano fijo. Con las filas del lado de construccion se arma una
+ * TablaHashInline de clave a filas, y cada fila del lado de sondeo busca en
+ * ella sus pares. El hash de cada fila se calcula una sola vez.
+ * En el modo particionado, antes de armar la tabla se reparten las filas de
+ * ambos lados en 2^bitsParticion particiones segun su hash, y se reune cada
+ * particion por separado: cada tabla tiene solo las filas de una particion y
+ * puede entrar en la cache aunque el lado de construccion no entre.
+ */
+
+/**
+ * Conjunto de numFilas filas consecutivas de tamFila bytes. En ambos lados la
+ * clave ocupa los primeros bytes de cada fila.
+ */
+typedef struct {
+  const void *filas;
+  size_t numFilas;
+  size_t tamFila;
+} Relacion;
+
+typedef void (*FuncionVisitanteReunion)(const void *filaConstruccion,
+                                        const void *filaSondeo, void *extra);
+/** Recibe cada par de filas con la misma clave junto con un puntero extra */
+
+/**
+ * Aplica visita a cada par de filas de construccion y sondeo con la misma
+ * clave, de tamClave bytes. La funcion hash recibe un puntero a una fila y
+ * debe depender solo de la clave; si comp es NULL, las claves se comparan con
+ * memcmp. Con bitsParticion 0 no se particiona.
+ */
+void reunionhash(Relacion construccion, Relacion sondeo, size_t tamClave,
+                 FuncionComparadora comp, FuncionHash hash,
+                 unsigned bitsParticion, FuncionVisitanteReunion visita,
+                 void *extra);
+
+#endif /* __REUNIONHASH_H__ */
@@ -1,6 +1,8 @@
 #ifndef __TABLAHASH_H__
 #define __TABLAHASH_H__
 
+#include <stddef.h>
+
 typedef void *(*FuncionCopiadora)(void *dato);
 /** Retorna una copia fisica del dato */
 typedef int (*FuncionComparadora)(void *dato1, void *dato2);
@@ -10,9 +12,64 @@ typedef void (*FuncionDestructora)(void *dato);
 /** Libera la memoria alocada para el dato */
 typedef unsigned (*FuncionHash)(void *dato);
 /** Retorna un entero sin signo para el dato */
+typedef void (*FuncionVisitanteTabla)(void *dato, void *extra);
+/** Recibe cada dato de la tabla junto con un puntero extra */
+typedef size_t (*FuncionTamano)(void *dato);
+/** Retorna la cantidad de bytes que ocupa el dato */
 
 typedef struct _TablaHash *TablaHash;
 
+typedef struct _TablaHashIter *TablaHashIter;
+
+/**
+ * Opciones de creacion de una tabla hash. Un campo en 0 toma el valor
+ * predeterminado de la implementacion, asi que unas opciones en 0 equivalen a
+ * crear la tabla con tablahash_crear.
+ */
+typedef struct {
+  float cargaMaxima;        // factor de carga a partir del cual la tabla crece.
+  float crecimiento;        // factor por el que crece la capacidad (2).
+  unsigned capacidadMinima; // la tabla nunca se achica por debajo de esta.
+  float cargaMinima;        // al eliminar, si el factor de carga queda por
+                            // debajo de este valor la tabla se achica (0: nunca).
+} TablaHashOpciones;
+
+/**
+ * Numero de posiciones de los histogramas de sondeos. La ultima acumula todas
+ * las busquedas de TABLAHASH_HISTOGRAMA - 1 sondeos o mas.
+ */
+#define TABLAHASH_HISTOGRAMA 16
+
+/**
+ * Estadisticas de una tabla hash, para diagnosticar su rendimiento.
+ * Los datos estructurales se calculan recorriendo la tabla y estan siempre
+ * disponibles. Los contadores de busquedas y redimensiones solo se acumulan si
+ * la implementacion se compila con TABLAHASH_INSTRUMENTAR (instrumentada == 1);
+ * si no, quedan en 0 y las operaciones no pagan ningun costo por ellos.
+ * Que cuenta como un sondeo depende de la implementacion: casillas visitadas
+ * (lp, sc), datos comparados en la cubeta y nodos del arbol de desborde (en),
+ * grupos de control revisados (simd) o cubetas y datos de la reserva revisados
+ * (cuckoo).
+ */
+typedef struct {
+  unsigned numElems;
+  unsigned capacidad;
+  unsigned casillasUsadas;   // casillas (o cubetas) con al menos un dato.
+  unsigned borradas;         // casillas marcadas como eliminadas.
+  unsigned desbordados;      // datos fuera de su lugar directo.
+  unsigned alturaMaxima;     // altura del arbol de desborde mas alto (en).
+  unsigned sondeoMaximo;     // sondeos de la busqueda exitosa mas larga.
+  int instrumentada;
+  unsigned long busquedasExitosas;
+  unsigned long busquedasFallidas;
+  double sondeosExitosa;     // promedio de sondeos por busqueda exitosa.
+  double sondeosFallida;     // promedio de sondeos por busqueda fallida.
+  unsigned long histogramaExitosas[TABLAHASH_HISTOGRAMA];
+  unsigned long histogramaFallidas[TABLAHASH_HISTOGRAMA];
+  unsigned long redimensiones;
+  double segundosRedimension;
+} TablaHashEstadisticas;
+
 /**
  * Crea una nueva tabla hash vacia, con la capacidad dada.
  */
@@ -20,6 +77,24 @@ TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
                           FuncionComparadora comp, FuncionDestructora destr,
                           FuncionHash hash);
 
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad y las opciones dadas.
+ * opciones puede ser NULL. Las implementaciones cuya capacidad es siempre una
+ * potencia de dos redondean hacia arriba las capacidades que resultan de las
+ * opciones. Las de direccionamiento abierto (lp, simd, cuckoo) bajan la carga
+ * maxima a una menor que 1, para que la tabla nunca se llene.
+ */
+TablaHash tablahash_crear_con_opciones(unsigned capacidad, FuncionCopiadora copia,
+                                       FuncionComparadora comp,
+                                       FuncionDestructora destr, FuncionHash hash,
+                                       const TablaHashOpciones *opciones);
+
+/**
+ * Agranda la tabla de una vez, si hace falta, para que entren n datos sin que
+ * se vuelva a redimensionar. Nunca la achica.
+ */
+void tablahash_reservar(TablaHash tabla, unsigned n);
+
 /**
  * Retorna el numero de elementos de la tabla.
  */
@@ -52,8 +127,90 @@ void *tablahash_buscar(TablaHash tabla, void *dato);
 void tablahash_eliminar(TablaHash tabla, void *dato);
 
 /**
- * Duplica la capacidad de la tabla y reposiciona todos los elementos de acuerdo a la nueva
- * posicion que le asigne la funcion de hash.
+ * Versiones de tablahash_insertar, tablahash_buscar y tablahash_eliminar para
+ * quien ya calculo el hash del dato y no quiere volver a calcularlo. hash debe
+ * ser lo que retorna la funcion hash de la tabla para el dato.
+ */
+void tablahash_insertar_hash(TablaHash tabla, void *dato, unsigned hash);
+void *tablahash_buscar_hash(TablaHash tabla, void *dato, unsigned hash);
+void tablahash_eliminar_hash(TablaHash tabla, void *dato, unsigned hash);
+
+/**
+ * Busca n datos de una vez: guarda en resultados[i] lo que retornaria
+ * tablahash_buscar(tabla, claves[i]). Calcula primero los hashes de todo un
+ * lote y adelanta la carga de sus casillas, asi las esperas a memoria se
+ * superponen en vez de sumarse.
+ */
+void tablahash_buscar_lote(TablaHash tabla, void **claves, size_t n,
+                           void **resultados);
+
+/**
+ * Inserta n datos de una vez, con el mismo efecto que llamar a
+ * tablahash_insertar con cada uno en orden.
+ */
+void tablahash_insertar_lote(TablaHash tabla, void **datos, size_t n);
+
+/**
+ * Multiplica la capacidad de la tabla por el factor de crecimiento (la duplica
+ * por defecto) y reposiciona todos los elementos de acuerdo a la nueva
+ * posicion que le asigne la funcion de hash. Si habia una redimension
+ * incremental en curso, primero la completa.
  */
 void tablahash_redimensionar(TablaHash tabla);
+
+/**
+ * Activa la redimension incremental: al superar el factor de carga, el arreglo
+ * anterior y el nuevo conviven y cada insercion, busqueda o eliminacion migra a
+ * lo sumo pasos casillas del anterior al nuevo. Con pasos == 0 (por defecto) la
+ * redimension se hace completa en una sola llamada.
+ */
+void tablahash_redimension_incremental(TablaHash tabla, unsigned pasos);
+
+/**
+ * Completa estadisticas con el estado actual de la tabla y, si esta
+ * instrumentada, con los contadores acumulados desde su creacion.
+ */
+void tablahash_estadisticas(TablaHash tabla, TablaHashEstadisticas *estadisticas);
+
+/**
+ * Aplica visita a cada dato de la tabla (sin copiarlo), en un orden no
+ * especificado. La funcion visitante no debe modificar la tabla.
+ */
+void tablahash_recorrer(TablaHash tabla, FuncionVisitanteTabla visita,
+                        void *extra);
+
+/**
+ * Crea un iterador sobre los datos de la tabla, que recorre las casillas en
+ * orden (incluidas las que todavia no se migraron del arreglo anterior).
+ * Mientras se use el iterador la tabla no debe modificarse; tampoco buscar en
+ * ella si la redimension incremental esta activa, porque la busqueda migra
+ * casillas.
+ */
+TablaHashIter tablahash_iter_crear(TablaHash tabla);
+
+/**
+ * Retorna el siguiente dato del iterador (sin copiarlo), o NULL si ya se
+ * recorrieron todos.
+ */
+void *tablahash_iter_siguiente(TablaHashIter iter);
+
+/**
+ * Destruye el iterador.
+ */
+void tablahash_iter_destruir(TablaHashIter iter);
+
+/**
+ * Recorrido por partes que admite modificar la tabla entre llamadas. Se
+ * empieza con cursor 0; cada llamada aplica visita a algunos datos y retorna
+ * el cursor para la siguiente, hasta que retorna 0. La funcion visitante no
+ * debe modificar la tabla.
+ * Los datos que esten en la tabla durante todo el recorrido se visitan, y los
+ * que se inserten o eliminen mientras tanto pueden visitarse o no. En lp y en
+ * (salvo con TABLAHASH_MODULO) esto vale aunque la tabla se redimensione entre
+ * llamadas, y ningun dato se visita dos veces; en las demas implementaciones
+ * el cursor es una posicion del arreglo y la garantia vale mientras la
+ * capacidad no cambie.
+ */
+unsigned tablahash_escanear(TablaHash tabla, unsigned cursor,
+                            FuncionVisitanteTabla visita, void *extra);
 #endif /* __TABLAHASH_H__ */
\ No newline at end of file
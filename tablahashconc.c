@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+#include "tablahashconc.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#define TAM_LINEA 64
+
+/**
+ * Fragmento de la tabla: una TablaHash y su candado. Cada fragmento ocupa su
+ * propia linea de cache para que los hilos que usan fragmentos distintos no
+ * se pisen.
+ */
+typedef struct {
+  _Alignas(TAM_LINEA) pthread_rwlock_t candado;
+  TablaHash tabla;
+} Fragmento;
+
+/**
+ * Estructura principal que representa la tabla.
+ * bits es el logaritmo en base 2 de numFragmentos.
+ */
+struct _TablaHashConc {
+  Fragmento *fragmentos;
+  unsigned numFragmentos;
+  unsigned bits;
+  FuncionCopiadora copia;
+  FuncionHash hash;
+};
+
+/**
+ * Crea una nueva tabla vacia con numFragmentos fragmentos, cada uno con la
+ * capacidad dada.
+ */
+TablaHashConc tablahashconc_crear(unsigned numFragmentos, unsigned capacidad,
+                                  FuncionCopiadora copia,
+                                  FuncionComparadora comp,
+                                  FuncionDestructora destr, FuncionHash hash) {
+  TablaHashConc tabla = malloc(sizeof(struct _TablaHashConc));
+  assert(tabla);
+  tabla->bits = 0;
+  while ((1u << tabla->bits) < numFragmentos)
+    tabla->bits++;
+  tabla->numFragmentos = 1u << tabla->bits;
+  tabla->copia = copia;
+  tabla->hash = hash;
+
+  tabla->fragmentos = aligned_alloc(TAM_LINEA,
+                                    sizeof(Fragmento) * tabla->numFragmentos);
+  assert(tabla->fragmentos);
+  for (unsigned i = 0; i < tabla->numFragmentos; ++i) {
+    int error = pthread_rwlock_init(&tabla->fragmentos[i].candado, NULL);
+    assert(error == 0);
+    (void)error;
+    // Los fragmentos no usan la redimension incremental: con ella una busqueda
+    // modificaria la tabla y no podria hacerse con el candado de lectura.
+    tabla->fragmentos[i].tabla =
+        tablahash_crear(capacidad, copia, comp, destr, hash);
+  }
+  return tabla;
+}
+
+/**
+ * Destruye la tabla.
+ */
+void tablahashconc_destruir(TablaHashConc tabla) {
+  for (unsigned i = 0; i < tabla->numFragmentos; ++i) {
+    tablahash_destruir(tabla->fragmentos[i].tabla);
+    pthread_rwlock_destroy(&tabla->fragmentos[i].candado);
+  }
+  free(tabla->fragmentos);
+  free(tabla);
+}
+
+/**
+ * Mezcla los bits del hash (el final de MurmurHash3) antes de elegir el
+ * fragmento. Si el fragmento saliera de los mismos bits con los que la tabla
+ * del fragmento elige la casilla (los altos del hash multiplicado en lp, por
+ * ejemplo), todos los datos de un fragmento caerian en la misma parte de su
+ * tabla.
+ */
+static unsigned tablahashconc_mezclar(unsigned hash) {
+  hash ^= hash >> 16;
+  hash *= 0x85EBCA6Bu;
+  hash ^= hash >> 13;
+  hash *= 0xC2B2AE35u;
+  return hash ^ (hash >> 16);
+}
+
+/**
+ * Retorna el fragmento que le corresponde al dato con el hash dado. Las
+ * operaciones calculan el hash una sola vez y se lo pasan tambien a la tabla
+ * del fragmento.
+ */
+static Fragmento *tablahashconc_fragmento(TablaHashConc tabla, unsigned hash) {
+  if (tabla->bits == 0)
+    return &tabla->fragmentos[0];
+  return &tabla->fragmentos[tablahashconc_mezclar(hash) >> (32 - tabla->bits)];
+}
+
+/**
+ * Retorna el numero de elementos de la tabla.
+ * Cada fragmento se cuenta bajo su candado, pero el total no es una foto
+ * atomica de la tabla si otros hilos la estan modificando.
+ */
+int tablahashconc_nelems(TablaHashConc tabla) {
+  int total = 0;
+  for (unsigned i = 0; i < tabla->numFragmentos; ++i) {
+    Fragmento *fragmento = &tabla->fragmentos[i];
+    pthread_rwlock_rdlock(&fragmento->candado);
+    total += tablahash_nelems(fragmento->tabla);
+    pthread_rwlock_unlock(&fragmento->candado);
+  }
+  return total;
+}
+
+/**
+ * Inserta un dato en la tabla, o lo reemplaza si ya se encontraba.
+ */
+void tablahashconc_insertar(TablaHashConc tabla, void *dato) {
+  unsigned hash = tabla->hash(dato);
+  Fragmento *fragmento = tablahashconc_fragmento(tabla, hash);
+  pthread_rwlock_wrlock(&fragmento->candado);
+  tablahash_insertar_hash(fragmento->tabla, dato, hash);
+  pthread_rwlock_unlock(&fragmento->candado);
+}
+
+/**
+ * Retorna una copia del dato de la tabla que coincida con el dato dado, o NULL
+ * si no se encuentra.
+ */
+void *tablahashconc_buscar(TablaHashConc tabla, void *dato) {
+  unsigned hash = tabla->hash(dato);
+  Fragmento *fragmento = tablahashconc_fragmento(tabla, hash);
+  pthread_rwlock_rdlock(&fragmento->candado);
+  void *encontrado = tablahash_buscar_hash(fragmento->tabla, dato, hash);
+  void *copia = (encontrado != NULL) ? tabla->copia(encontrado) : NULL;
+  pthread_rwlock_unlock(&fragmento->candado);
+  return copia;
+}
+
+/**
+ * Elimina el dato de la tabla que coincida con el dato dado.
+ */
+void tablahashconc_eliminar(TablaHashConc tabla, void *dato) {
+  unsigned hash = tabla->hash(dato);
+  Fragmento *fragmento = tablahashconc_fragmento(tabla, hash);
+  pthread_rwlock_wrlock(&fragmento->candado);
+  tablahash_eliminar_hash(fragmento->tabla, dato, hash);
+  pthread_rwlock_unlock(&fragmento->candado);
+}
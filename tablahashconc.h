@@ -0,0 +1,51 @@
+#ifndef __TABLAHASHCONC_H__
+#define __TABLAHASHCONC_H__
+
+#include "tablahash.h"
+
+/**
+ * Tabla hash para varios hilos, formada por fragmentos independientes. Cada
+ * fragmento es una TablaHash con su propio candado de lectura/escritura, y el
+ * fragmento de cada dato se elige con los bits altos de una mezcla de su hash
+ * distinta de la que usa la tabla del fragmento para elegir la casilla. Cada
+ * fragmento se redimensiona por su cuenta, sin bloquear a los demas.
+ */
+typedef struct _TablaHashConc *TablaHashConc;
+
+/**
+ * Crea una nueva tabla vacia con numFragmentos fragmentos (redondeado hacia
+ * arriba a una potencia de dos), cada uno con la capacidad dada.
+ */
+TablaHashConc tablahashconc_crear(unsigned numFragmentos, unsigned capacidad,
+                                  FuncionCopiadora copia,
+                                  FuncionComparadora comp,
+                                  FuncionDestructora destr, FuncionHash hash);
+
+/**
+ * Destruye la tabla. No debe haber otros hilos usandola.
+ */
+void tablahashconc_destruir(TablaHashConc tabla);
+
+/**
+ * Retorna el numero de elementos de la tabla.
+ */
+int tablahashconc_nelems(TablaHashConc tabla);
+
+/**
+ * Inserta un dato en la tabla, o lo reemplaza si ya se encontraba.
+ */
+void tablahashconc_insertar(TablaHashConc tabla, void *dato);
+
+/**
+ * Retorna una copia del dato de la tabla que coincida con el dato dado, o NULL
+ * si no se encuentra. Como otro hilo puede eliminar el dato en cualquier
+ * momento, se retorna una copia, que debe destruir quien llama.
+ */
+void *tablahashconc_buscar(TablaHashConc tabla, void *dato);
+
+/**
+ * Elimina el dato de la tabla que coincida con el dato dado.
+ */
+void tablahashconc_eliminar(TablaHashConc tabla, void *dato);
+
+#endif /* __TABLAHASHCONC_H__ */
@@ -0,0 +1,107 @@
+#ifndef __TABLAHASHCONTADORES_H__
+#define __TABLAHASHCONTADORES_H__
+
+#include "tablahash.h"
+#include <stddef.h>
+
+/**
+ * Contadores de instrumentacion que comparten las implementaciones de la tabla
+ * hash. Solo existen si se compila con TABLAHASH_INSTRUMENTAR: en otro caso
+ * las macros no generan codigo y la tabla no guarda ningun contador.
+ *
+ * Uso en una implementacion:
+ *  - CONTADORES_CAMPO dentro de struct _TablaHash,
+ *  - CONTAR(sondeos, n) donde la busqueda revisa n posiciones (sondeos es un
+ *    unsigned * que puede ser NULL para no contar),
+ *  - REGISTRAR_BUSQUEDA(tabla, sondeos, exito) al terminar una busqueda,
+ *  - RELOJ_INICIAR(t) y RELOJ_DETENER(tabla, t) alrededor del trabajo de
+ *    redimension, y REGISTRAR_REDIMENSION(tabla) al empezar una,
+ *  - contadores_volcar(tabla, estadisticas) en tablahash_estadisticas.
+ *
+ * Las busquedas se cuentan con sumas atomicas relajadas, porque
+ * tablahashconc busca en cada fragmento con el candado de lectura y varios
+ * hilos pueden registrar busquedas en la misma tabla a la vez. Las
+ * redimensiones no lo necesitan: solo ocurren al insertar o eliminar, cuando
+ * un unico hilo usa la tabla.
+ */
+#ifdef TABLAHASH_INSTRUMENTAR
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+  unsigned long busquedas[2]; // [0] fallidas, [1] exitosas.
+  unsigned long sondeos[2];
+  unsigned long histograma[2][TABLAHASH_HISTOGRAMA];
+  unsigned long redimensiones;
+  double segundos;
+} Contadores;
+
+static inline double contadores_reloj(void) {
+  struct timespec t;
+  timespec_get(&t, TIME_UTC);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static inline void contadores_sumar(unsigned long *contador,
+                                    unsigned long n) {
+  __atomic_fetch_add(contador, n, __ATOMIC_RELAXED);
+}
+
+static inline unsigned long contadores_leer(const unsigned long *contador) {
+  return __atomic_load_n(contador, __ATOMIC_RELAXED);
+}
+
+static inline void contadores_busqueda(Contadores *c, unsigned sondeos,
+                                       int exito) {
+  exito = exito != 0;
+  contadores_sumar(&c->busquedas[exito], 1);
+  contadores_sumar(&c->sondeos[exito], sondeos);
+  contadores_sumar(&c->histograma[exito][sondeos < TABLAHASH_HISTOGRAMA
+                                             ? sondeos
+                                             : TABLAHASH_HISTOGRAMA - 1],
+                   1);
+}
+
+static inline void contadores_copiar(const Contadores *c,
+                                     TablaHashEstadisticas *e) {
+  e->instrumentada = 1;
+  e->busquedasFallidas = contadores_leer(&c->busquedas[0]);
+  e->busquedasExitosas = contadores_leer(&c->busquedas[1]);
+  unsigned long sondeosFallidas = contadores_leer(&c->sondeos[0]);
+  unsigned long sondeosExitosas = contadores_leer(&c->sondeos[1]);
+  e->sondeosFallida = e->busquedasFallidas
+                          ? (double)sondeosFallidas / e->busquedasFallidas : 0;
+  e->sondeosExitosa = e->busquedasExitosas
+                          ? (double)sondeosExitosas / e->busquedasExitosas : 0;
+  for (int i = 0; i < TABLAHASH_HISTOGRAMA; i++) {
+    e->histogramaFallidas[i] = contadores_leer(&c->histograma[0][i]);
+    e->histogramaExitosas[i] = contadores_leer(&c->histograma[1][i]);
+  }
+  e->redimensiones = c->redimensiones;
+  e->segundosRedimension = c->segundos;
+}
+
+#define CONTADORES_CAMPO Contadores contadores;
+#define CONTADORES_INICIAR(tabla) \
+  memset(&(tabla)->contadores, 0, sizeof(Contadores))
+#define CONTAR(sondeos, n) \
+  ((sondeos) != NULL ? (void)(*(sondeos) += (n)) : (void)0)
+#define REGISTRAR_BUSQUEDA(tabla, sondeos, exito) \
+  contadores_busqueda(&(tabla)->contadores, (sondeos), (exito))
+#define REGISTRAR_REDIMENSION(tabla) ((tabla)->contadores.redimensiones++)
+#define RELOJ_INICIAR(t) double t = contadores_reloj()
+#define RELOJ_DETENER(tabla, t) \
+  ((tabla)->contadores.segundos += contadores_reloj() - (t))
+#define contadores_volcar(tabla, e) contadores_copiar(&(tabla)->contadores, (e))
+#else
+#define CONTADORES_CAMPO
+#define CONTADORES_INICIAR(tabla) ((void)0)
+#define CONTAR(sondeos, n) ((void)(sondeos))
+#define REGISTRAR_BUSQUEDA(tabla, sondeos, exito) ((void)0)
+#define REGISTRAR_REDIMENSION(tabla) ((void)0)
+#define RELOJ_INICIAR(t) ((void)0)
+#define RELOJ_DETENER(tabla, t) ((void)0)
+#define contadores_volcar(tabla, e) ((void)0)
+#endif
+
+#endif /* __TABLAHASHCONTADORES_H__ */
@@ -0,0 +1,602 @@
+#include "tablahashcuckoo.h"
+#include "tablahashcontadores.h"
+#include "tablahashopciones.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#define FACTOR_CARGA(numElms, casillas) ((float)(numElms)/(casillas))
+#define LIMITE 0.95
+// Mayor carga maxima admitida: por encima, casi toda insercion termina en
+// una cadena de desalojos fallida.
+#define CARGA_TOPE 0.98
+#define TAM_LOTE 16
+//IMPLEMENTACION DE TABLA HASH CON CUCKOO HASHING POR CUBETAS.//
+/**
+ * Cada dato puede estar en solo dos cubetas de TAM_CUBETA casillas, elegidas
+ * con dos mezclas distintas del valor de la funcion hash. Una busqueda mira a
+ * lo sumo esas 2 * TAM_CUBETA casillas. Si al insertar ambas cubetas estan
+ * llenas, se busca a lo ancho (BFS) un camino de datos que puedan mudarse a su
+ * otra cubeta hasta llegar a una con lugar, y se lo recorre de atras hacia
+ * adelante.
+ * Si el camino no existe aunque la tabla este poco cargada (muchos datos con
+ * el mismo hash), redimensionar no ayuda: esos datos van a una reserva aparte
+ * que se revisa solo cuando no esta vacia.
+ */
+#define TAM_CUBETA 4
+#define MAX_CAMINO 512
+#define CARGA_RESERVA 0.5
+
+/**
+ * Estructura principal que representa la tabla hash.
+ * Una casilla esta libre si su dato es NULL. Junto a cada dato se guarda su
+ * hash, para poder calcular su otra cubeta sin llamar a la funcion hash.
+ */
+struct _TablaHash {
+  void **datos;
+  unsigned *hashes;
+  void **reserva;
+  unsigned *hashesReserva;
+  unsigned numReserva;
+  unsigned capacidadReserva;
+  unsigned numElems;
+  unsigned numCubetas;
+  unsigned long desplazamientos;
+  float cargaMaxima;
+  FuncionCopiadora copia;
+  FuncionComparadora comp;
+  FuncionDestructora destr;
+  FuncionHash hash;
+  TablaHashOpciones opciones;
+  CONTADORES_CAMPO
+};
+
+/**
+ * Nodo de la busqueda a lo ancho: la cubeta alcanzada, el nodo desde el que se
+ * llego (o -1 si es una de las cubetas del dato a insertar) y la casilla de la
+ * cubeta del padre cuyo dato se mudaria a esta cubeta.
+ */
+typedef struct {
+  unsigned cubeta;
+  int padre;
+  unsigned casilla;
+} NodoCamino;
+
+/**
+ * Mezclas del hash para elegir la primera y la segunda cubeta.
+ */
+static unsigned mezclar(unsigned h, unsigned semilla) {
+  h ^= semilla;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+static unsigned cubeta_primera(TablaHash tabla, unsigned hash) {
+  return mezclar(hash, 0) % tabla->numCubetas;
+}
+static unsigned cubeta_segunda(TablaHash tabla, unsigned hash) {
+  unsigned primera = cubeta_primera(tabla, hash);
+  unsigned segunda = mezclar(hash, 0x9e3779b9u) % tabla->numCubetas;
+  if (segunda == primera)
+    segunda = (segunda + 1) % tabla->numCubetas;
+  return segunda;
+}
+/**
+ * Retorna la cubeta alternativa para un dato de hash dado que esta en cubeta.
+ */
+static unsigned cubeta_otra(TablaHash tabla, unsigned cubeta, unsigned hash) {
+  unsigned primera = cubeta_primera(tabla, hash);
+  return (cubeta == primera) ? cubeta_segunda(tabla, hash) : primera;
+}
+
+/**
+ * Pide memoria para numCubetas cubetas vacias.
+ */
+static void tablahash_inicializar_cubetas(TablaHash tabla, unsigned numCubetas) {
+  unsigned capacidad = numCubetas * TAM_CUBETA;
+  tabla->datos = malloc(sizeof(void *) * capacidad);
+  assert(tabla->datos);
+  tabla->hashes = malloc(sizeof(unsigned) * capacidad);
+  assert(tabla->hashes);
+  for (unsigned i = 0; i < capacidad; ++i)
+    tabla->datos[i] = NULL;
+  tabla->numCubetas = numCubetas;
+  tabla->numElems = 0;
+}
+
+/**
+ * Retorna la cantidad de cubetas necesaria para la capacidad dada (al menos
+ * dos).
+ */
+static unsigned tablahash_cubetas_para(unsigned capacidad) {
+  unsigned numCubetas = (capacidad + TAM_CUBETA - 1) / TAM_CUBETA;
+  return numCubetas < 2 ? 2 : numCubetas;
+}
+
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad y las opciones dadas.
+ * La capacidad se redondea hacia arriba a un multiplo de TAM_CUBETA, con al
+ * menos dos cubetas.
+ */
+TablaHash tablahash_crear_con_opciones(unsigned capacidad, FuncionCopiadora copia,
+                                       FuncionComparadora comp,
+                                       FuncionDestructora destr, FuncionHash hash,
+                                       const TablaHashOpciones *opciones) {
+  TablaHash tabla = malloc(sizeof(struct _TablaHash));
+  assert(tabla);
+  tabla->copia = copia;
+  tabla->comp = comp;
+  tabla->destr = destr;
+  tabla->hash = hash;
+  tabla->desplazamientos = 0;
+  tabla->cargaMaxima = 0;
+  tabla->reserva = NULL;
+  tabla->hashesReserva = NULL;
+  tabla->numReserva = 0;
+  tabla->capacidadReserva = 0;
+  tabla->opciones = tablahash_opciones_completar(opciones, LIMITE, CARGA_TOPE);
+  CONTADORES_INICIAR(tabla);
+
+  if (capacidad < tabla->opciones.capacidadMinima)
+    capacidad = tabla->opciones.capacidadMinima;
+  tablahash_inicializar_cubetas(tabla, tablahash_cubetas_para(capacidad));
+  return tabla;
+}
+
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad dada.
+ * La capacidad se redondea hacia arriba a un multiplo de TAM_CUBETA, con al
+ * menos dos cubetas.
+ */
+TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
+                          FuncionComparadora comp, FuncionDestructora destr,
+                          FuncionHash hash) {
+  return tablahash_crear_con_opciones(capacidad, copia, comp, destr, hash, NULL);
+}
+
+/**
+ * Retorna el numero de elementos de la tabla.
+ */
+int tablahash_nelems(TablaHash tabla) { return tabla->numElems; }
+
+/**
+ * Retorna la capacidad de la tabla.
+ */
+int tablahash_capacidad(TablaHash tabla) {
+  return tabla->numCubetas * TAM_CUBETA;
+}
+
+/**
+ * Retorna la cantidad de datos desplazados desde que se creo la tabla.
+ */
+unsigned long tablahash_cuckoo_desplazamientos(TablaHash tabla) {
+  return tabla->desplazamientos;
+}
+
+/**
+ * Retorna el mayor factor de carga alcanzado antes de una insercion fallida.
+ */
+float tablahash_cuckoo_carga_maxima(TablaHash tabla) {
+  return tabla->cargaMaxima;
+}
+
+/**
+ * Destruye la tabla.
+ */
+void tablahash_destruir(TablaHash tabla) {
+  unsigned capacidad = tabla->numCubetas * TAM_CUBETA;
+  for (unsigned idx = 0; idx < capacidad; ++idx)
+    if (tabla->datos[idx] != NULL)
+      tabla->destr(tabla->datos[idx]);
+  for (unsigned i = 0; i < tabla->numReserva; ++i)
+    tabla->destr(tabla->reserva[i]);
+  free(tabla->datos);
+  free(tabla->hashes);
+  free(tabla->reserva);
+  free(tabla->hashesReserva);
+  free(tabla);
+}
+
+/**
+ * Retorna la casilla de la cubeta que contiene al dato, o -1 si no esta.
+ */
+static long cubeta_buscar(TablaHash tabla, unsigned cubeta, void *dato,
+                          unsigned hash) {
+  for (unsigned i = 0; i < TAM_CUBETA; ++i) {
+    unsigned idx = cubeta * TAM_CUBETA + i;
+    if (tabla->datos[idx] != NULL && tabla->hashes[idx] == hash &&
+        tabla->comp(tabla->datos[idx], dato) == 0)
+      return idx;
+  }
+  return -1;
+}
+
+/**
+ * Retorna la primera casilla libre de la cubeta, o -1 si esta llena.
+ */
+static long cubeta_libre(TablaHash tabla, unsigned cubeta) {
+  for (unsigned i = 0; i < TAM_CUBETA; ++i)
+    if (tabla->datos[cubeta * TAM_CUBETA + i] == NULL)
+      return cubeta * TAM_CUBETA + i;
+  return -1;
+}
+
+/**
+ * Retorna la casilla que contiene al dato, mirando solo sus dos cubetas, o -1
+ * si no esta en ellas. Si sondeos no es NULL, le suma las cubetas revisadas.
+ */
+static long tablahash_posicion(TablaHash tabla, void *dato, unsigned hash,
+                               unsigned *sondeos) {
+  CONTAR(sondeos, 1);
+  long idx = cubeta_buscar(tabla, cubeta_primera(tabla, hash), dato, hash);
+  if (idx == -1) {
+    CONTAR(sondeos, 1);
+    idx = cubeta_buscar(tabla, cubeta_segunda(tabla, hash), dato, hash);
+  }
+  return idx;
+}
+
+/**
+ * Retorna la direccion donde esta guardado el dato (en sus cubetas o en la
+ * reserva), o NULL si no esta en la tabla. Si sondeos no es NULL, le suma las
+ * cubetas y los datos de la reserva revisados.
+ */
+static void **tablahash_lugar(TablaHash tabla, void *dato, unsigned hash,
+                              unsigned *sondeos) {
+  long idx = tablahash_posicion(tabla, dato, hash, sondeos);
+  if (idx != -1)
+    return &tabla->datos[idx];
+  for (unsigned i = 0; i < tabla->numReserva; ++i) {
+    CONTAR(sondeos, 1);
+    if (tabla->hashesReserva[i] == hash && tabla->comp(tabla->reserva[i], dato) == 0)
+      return &tabla->reserva[i];
+  }
+  return NULL;
+}
+
+/**
+ * Agrega un dato a la reserva, sin copiarlo.
+ */
+static void tablahash_reservar_dato(TablaHash tabla, void *dato, unsigned hash) {
+  if (tabla->numReserva == tabla->capacidadReserva) {
+    tabla->capacidadReserva = tabla->capacidadReserva ? tabla->capacidadReserva * 2 : 4;
+    tabla->reserva = realloc(tabla->reserva, sizeof(void *) * tabla->capacidadReserva);
+    assert(tabla->reserva);
+    tabla->hashesReserva = realloc(tabla->hashesReserva,
+                                   sizeof(unsigned) * tabla->capacidadReserva);
+    assert(tabla->hashesReserva);
+  }
+  tabla->reserva[tabla->numReserva] = dato;
+  tabla->hashesReserva[tabla->numReserva] = hash;
+  tabla->numReserva++;
+  tabla->numElems++;
+}
+
+/**
+ * Coloca un dato (que no estaba en la tabla) en una de sus dos cubetas, sin
+ * copiarlo, desplazando otros datos si hace falta. Retorna 1 si lo logro y 0
+ * si no hay un camino de desplazamientos de a lo sumo MAX_CAMINO nodos.
+ */
+static int tablahash_colocar(TablaHash tabla, void *dato, unsigned hash) {
+  NodoCamino cola[MAX_CAMINO];
+  int primero = 0, ultimo = 0;
+  cola[ultimo++] = (NodoCamino){cubeta_primera(tabla, hash), -1, 0};
+  cola[ultimo++] = (NodoCamino){cubeta_segunda(tabla, hash), -1, 0};
+
+  while (primero < ultimo) {
+    int actual = primero++;
+    long libre = cubeta_libre(tabla, cola[actual].cubeta);
+    if (libre != -1) {
+      // Recorremos el camino hacia atras: cada dato se muda a la casilla que
+      // libero el siguiente.
+      while (cola[actual].padre != -1) {
+        NodoCamino *padre = &cola[cola[actual].padre];
+        long origen = padre->cubeta * TAM_CUBETA + cola[actual].casilla;
+        tabla->datos[libre] = tabla->datos[origen];
+        tabla->hashes[libre] = tabla->hashes[origen];
+        tabla->datos[origen] = NULL;
+        tabla->desplazamientos++;
+        libre = origen;
+        actual = cola[actual].padre;
+      }
+      tabla->datos[libre] = dato;
+      tabla->hashes[libre] = hash;
+      tabla->numElems++;
+      return 1;
+    }
+    // La cubeta esta llena: cada uno de sus datos podria mudarse a su otra
+    // cubeta.
+    for (unsigned i = 0; i < TAM_CUBETA && ultimo < MAX_CAMINO; ++i) {
+      unsigned idx = cola[actual].cubeta * TAM_CUBETA + i;
+      unsigned otra = cubeta_otra(tabla, cola[actual].cubeta, tabla->hashes[idx]);
+      cola[ultimo++] = (NodoCamino){otra, actual, i};
+    }
+  }
+  return 0;
+}
+
+/**
+ * Reubica todos los elementos en numCubetas cubetas nuevas, de acuerdo a la
+ * posicion que les asigne la funcion de hash. Los datos de la reserva vuelven
+ * a intentar ubicarse en sus cubetas, y los que no encuentran lugar quedan en
+ * ella.
+ */
+static void tablahash_reubicar(TablaHash tabla, unsigned numCubetas) {
+  RELOJ_INICIAR(inicio);
+  REGISTRAR_REDIMENSION(tabla);
+  //Guardo la informacion de la tabla.
+  void **datosAnteriores = tabla->datos;
+  unsigned *hashesAnteriores = tabla->hashes;
+  unsigned capacidadAnterior = tabla->numCubetas * TAM_CUBETA;
+  void **reservaAnterior = tabla->reserva;
+  unsigned *hashesReservaAnterior = tabla->hashesReserva;
+  unsigned numReservaAnterior = tabla->numReserva;
+
+  tablahash_inicializar_cubetas(tabla, numCubetas);
+  tabla->reserva = NULL;
+  tabla->hashesReserva = NULL;
+  tabla->numReserva = 0;
+  tabla->capacidadReserva = 0;
+  //Reubico los elementos anteriores sin copiarlos.
+  for (unsigned i = 0; i < capacidadAnterior; i++)
+    if (datosAnteriores[i] != NULL &&
+        !tablahash_colocar(tabla, datosAnteriores[i], hashesAnteriores[i]))
+      tablahash_reservar_dato(tabla, datosAnteriores[i], hashesAnteriores[i]);
+  for (unsigned i = 0; i < numReservaAnterior; i++)
+    if (!tablahash_colocar(tabla, reservaAnterior[i], hashesReservaAnterior[i]))
+      tablahash_reservar_dato(tabla, reservaAnterior[i], hashesReservaAnterior[i]);
+  free(datosAnteriores);
+  free(hashesAnteriores);
+  free(reservaAnterior);
+  free(hashesReservaAnterior);
+  RELOJ_DETENER(tabla, inicio);
+}
+
+/**
+ * Agranda la tabla de una vez para que entren n datos sin redimensionar.
+ */
+void tablahash_reservar(TablaHash tabla, unsigned n) {
+  unsigned numCubetas =
+      tablahash_cubetas_para(tablahash_capacidad_para(&tabla->opciones, n));
+  if (numCubetas > tabla->numCubetas)
+    tablahash_reubicar(tabla, numCubetas);
+}
+
+/**
+ * Inserta un dato en la tabla, o lo reemplaza si ya se encontraba.
+ */
+void tablahash_insertar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  void **lugar = tablahash_lugar(tabla, dato, hash, NULL);
+  // Caso en que el dato ya se encontraba.
+  if (lugar != NULL) {
+    tabla->destr(*lugar);
+    *lugar = tabla->copia(dato);
+    return;
+  }
+  if (FACTOR_CARGA(tabla->numElems + 1, tabla->numCubetas * TAM_CUBETA) >
+      tabla->opciones.cargaMaxima)
+    tablahash_redimensionar(tabla);
+
+  void *copia = tabla->copia(dato);
+  while (!tablahash_colocar(tabla, copia, hash)) {
+    float carga = FACTOR_CARGA(tabla->numElems, tabla->numCubetas * TAM_CUBETA);
+    // Con la tabla poco cargada, agrandarla no va a abrir un camino.
+    if (carga < CARGA_RESERVA) {
+      tablahash_reservar_dato(tabla, copia, hash);
+      return;
+    }
+    if (carga > tabla->cargaMaxima)
+      tabla->cargaMaxima = carga;
+    tablahash_redimensionar(tabla);
+  }
+}
+void tablahash_insertar(TablaHash tabla, void *dato) {
+  tablahash_insertar_hash(tabla, dato, tabla->hash(dato));
+}
+
+/**
+ * Retorna el dato de la tabla que coincida con el dato dado, o NULL si el dato
+ * buscado no se encuentra en la tabla.
+ */
+void *tablahash_buscar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  unsigned sondeos = 0;
+  void **lugar = tablahash_lugar(tabla, dato, hash, &sondeos);
+  REGISTRAR_BUSQUEDA(tabla, sondeos, lugar != NULL);
+  return (lugar != NULL) ? *lugar : NULL;
+}
+void *tablahash_buscar(TablaHash tabla, void *dato) {
+  return tablahash_buscar_hash(tabla, dato, tabla->hash(dato));
+}
+
+/**
+ * Calcula los hashes de un lote de a lo sumo TAM_LOTE datos y adelanta la
+ * carga de sus dos cubetas.
+ */
+static void tablahash_preparar_lote(TablaHash tabla, void **datos, size_t n,
+                                    unsigned *hashes) {
+  for (size_t i = 0; i < n; i++) {
+    hashes[i] = tabla->hash(datos[i]);
+    __builtin_prefetch(&tabla->hashes[cubeta_primera(tabla, hashes[i]) * TAM_CUBETA]);
+    __builtin_prefetch(&tabla->hashes[cubeta_segunda(tabla, hashes[i]) * TAM_CUBETA]);
+  }
+}
+
+/**
+ * Busca n datos de una vez, de a lotes de TAM_LOTE.
+ */
+void tablahash_buscar_lote(TablaHash tabla, void **claves, size_t n,
+                           void **resultados) {
+  unsigned hashes[TAM_LOTE];
+  for (size_t inicio = 0; inicio < n; inicio += TAM_LOTE) {
+    size_t lote = (n - inicio < TAM_LOTE) ? n - inicio : TAM_LOTE;
+    tablahash_preparar_lote(tabla, &claves[inicio], lote, hashes);
+    for (size_t i = 0; i < lote; i++)
+      resultados[inicio + i] = tablahash_buscar_hash(tabla, claves[inicio + i], hashes[i]);
+  }
+}
+
+/**
+ * Inserta n datos de una vez, de a lotes de TAM_LOTE.
+ */
+void tablahash_insertar_lote(TablaHash tabla, void **datos, size_t n) {
+  unsigned hashes[TAM_LOTE];
+  for (size_t inicio = 0; inicio < n; inicio += TAM_LOTE) {
+    size_t lote = (n - inicio < TAM_LOTE) ? n - inicio : TAM_LOTE;
+    tablahash_preparar_lote(tabla, &datos[inicio], lote, hashes);
+    for (size_t i = 0; i < lote; i++)
+      tablahash_insertar_hash(tabla, datos[inicio + i], hashes[i]);
+  }
+}
+
+/**
+ * Elimina el dato de la tabla que coincida con el dato dado.
+ */
+void tablahash_eliminar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  void **lugar = tablahash_lugar(tabla, dato, hash, NULL);
+  if (lugar == NULL)
+    return;
+  tabla->destr(*lugar);
+  tabla->numElems--;
+  if (lugar >= tabla->reserva && lugar < tabla->reserva + tabla->numReserva) {
+    // Tapamos el hueco de la reserva con su ultimo dato.
+    unsigned i = lugar - tabla->reserva;
+    tabla->numReserva--;
+    tabla->reserva[i] = tabla->reserva[tabla->numReserva];
+    tabla->hashesReserva[i] = tabla->hashesReserva[tabla->numReserva];
+  }
+  else
+    *lugar = NULL;
+
+  // Si quedo por debajo de la carga minima, achicamos la tabla.
+  unsigned numCubetas = tablahash_cubetas_para(tablahash_capacidad_achicada(
+      &tabla->opciones, tabla->numElems, tabla->numCubetas * TAM_CUBETA));
+  if (numCubetas < tabla->numCubetas)
+    tablahash_reubicar(tabla, numCubetas);
+}
+void tablahash_eliminar(TablaHash tabla, void *dato) {
+  tablahash_eliminar_hash(tabla, dato, tabla->hash(dato));
+}
+
+/**
+ * Multiplica la capacidad de la tabla por el factor de crecimiento y reposiciona todos los
+ * elementos de acuerdo a la nueva posicion que le asigne la funcion de hash. Los datos de la
+ * reserva vuelven a intentar ubicarse en sus cubetas, y los que no encuentran lugar quedan en
+ * ella.
+ */
+void tablahash_redimensionar(TablaHash tabla) {
+  unsigned numCubetas = tablahash_cubetas_para(tablahash_capacidad_crecida(
+      &tabla->opciones, tabla->numCubetas * TAM_CUBETA));
+  tablahash_reubicar(tabla, (numCubetas > tabla->numCubetas) ? numCubetas
+                                                              : tabla->numCubetas + 1);
+}
+
+/**
+ * En esta implementacion la redimension es siempre completa, asi que pasos se
+ * ignora.
+ */
+void tablahash_redimension_incremental(TablaHash tabla, unsigned pasos) {
+  (void)tabla;
+  (void)pasos;
+}
+
+/**
+ * Completa estadisticas con el estado actual de la tabla y, si esta
+ * instrumentada, con los contadores acumulados desde su creacion.
+ * Los datos desbordados son los de la reserva.
+ */
+void tablahash_estadisticas(TablaHash tabla, TablaHashEstadisticas *estadisticas) {
+  memset(estadisticas, 0, sizeof(TablaHashEstadisticas));
+  estadisticas->numElems = tabla->numElems;
+  estadisticas->capacidad = tabla->numCubetas * TAM_CUBETA;
+  estadisticas->desbordados = tabla->numReserva;
+  for (unsigned cubeta = 0; cubeta < tabla->numCubetas; ++cubeta) {
+    int usada = 0;
+    for (unsigned i = 0; i < TAM_CUBETA; ++i) {
+      unsigned idx = cubeta * TAM_CUBETA + i;
+      if (tabla->datos[idx] == NULL)
+        continue;
+      usada = 1;
+      unsigned sondeos = (cubeta_primera(tabla, tabla->hashes[idx]) == cubeta) ? 1 : 2;
+      if (sondeos > estadisticas->sondeoMaximo)
+        estadisticas->sondeoMaximo = sondeos;
+    }
+    estadisticas->casillasUsadas += usada;
+  }
+  if (tabla->numReserva > 0)
+    estadisticas->sondeoMaximo = 2 + tabla->numReserva;
+  contadores_volcar(tabla, estadisticas);
+}
+
+/**
+ * Aplica visita a cada dato de la tabla, incluidos los de la reserva.
+ */
+void tablahash_recorrer(TablaHash tabla, FuncionVisitanteTabla visita,
+                        void *extra) {
+  unsigned capacidad = tabla->numCubetas * TAM_CUBETA;
+  for (unsigned idx = 0; idx < capacidad; ++idx)
+    if (tabla->datos[idx] != NULL)
+      visita(tabla->datos[idx], extra);
+  for (unsigned i = 0; i < tabla->numReserva; ++i)
+    visita(tabla->reserva[i], extra);
+}
+
+/**
+ * Estructura del iterador: la proxima casilla a revisar. Las casillas de la
+ * reserva siguen a las de las cubetas.
+ */
+struct _TablaHashIter {
+  TablaHash tabla;
+  unsigned idx;
+};
+
+/**
+ * Crea un iterador sobre los datos de la tabla.
+ */
+TablaHashIter tablahash_iter_crear(TablaHash tabla) {
+  TablaHashIter iter = malloc(sizeof(struct _TablaHashIter));
+  assert(iter);
+  iter->tabla = tabla;
+  iter->idx = 0;
+  return iter;
+}
+
+/**
+ * Retorna el siguiente dato del iterador, o NULL si ya se recorrieron todos.
+ */
+void *tablahash_iter_siguiente(TablaHashIter iter) {
+  TablaHash tabla = iter->tabla;
+  unsigned capacidad = tabla->numCubetas * TAM_CUBETA;
+  for (; iter->idx < capacidad; ++iter->idx)
+    if (tabla->datos[iter->idx] != NULL)
+      return tabla->datos[iter->idx++];
+  if (iter->idx - capacidad < tabla->numReserva)
+    return tabla->reserva[iter->idx++ - capacidad];
+  return NULL;
+}
+
+/**
+ * Destruye el iterador.
+ */
+void tablahash_iter_destruir(TablaHashIter iter) {
+  free(iter);
+}
+
+/**
+ * Recorrido por partes. Las cubetas de cada dato dependen de la cantidad de
+ * cubetas, asi que el cursor es simplemente la cubeta a visitar; la reserva
+ * se visita junto con la ultima.
+ */
+unsigned tablahash_escanear(TablaHash tabla, unsigned cursor,
+                            FuncionVisitanteTabla visita, void *extra) {
+  if (cursor < tabla->numCubetas)
+    for (unsigned i = 0; i < TAM_CUBETA; ++i)
+      if (tabla->datos[cursor * TAM_CUBETA + i] != NULL)
+        visita(tabla->datos[cursor * TAM_CUBETA + i], extra);
+  if (cursor + 1 < tabla->numCubetas)
+    return cursor + 1;
+  for (unsigned i = 0; i < tabla->numReserva; ++i)
+    visita(tabla->reserva[i], extra);
+  return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef __TABLAHASHCUCKOO_H__
+#define __TABLAHASHCUCKOO_H__
+
+#include "tablahash.h"
+
+/**
+ * Funciones propias de la implementacion con cuckoo hashing (tablahashcuckoo.c),
+ * ademas de las de tablahash.h.
+ */
+
+/**
+ * Retorna la cantidad total de datos desplazados de su cubeta para hacer lugar
+ * a otros desde que se creo la tabla.
+ */
+unsigned long tablahash_cuckoo_desplazamientos(TablaHash tabla);
+
+/**
+ * Retorna el mayor factor de carga alcanzado antes de que una insercion no
+ * encontrara lugar y obligara a redimensionar, o 0 si eso nunca paso.
+ */
+float tablahash_cuckoo_carga_maxima(TablaHash tabla);
+
+#endif /* __TABLAHASHCUCKOO_H__ */
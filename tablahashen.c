@@ -1,8 +1,26 @@
 #include "tablahash.h"
+#include "tablahashcontadores.h"
+#include "tablahashopciones.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #define FACTOR_CARGA(numElms, casillas) ((float)(numElms)/(casillas))
 #define LIMITE 0.7
+#define TAM_LOTE 16
+/**
+ * Reduccion del hash a una casilla de la tabla. Por defecto la capacidad es
+ * siempre una potencia de dos y la casilla son los bits altos del hash
+ * multiplicado por 2^32 / phi (hashing de Fibonacci), sin division. Compilando
+ * con TABLAHASH_MODULO se vuelve a la reduccion con %, para comparar.
+ */
+#ifdef TABLAHASH_MODULO
+#define INDICE(hash, capacidad) ((hash) % (capacidad))
+#define MEZCLA(hash) (hash)
+#else
+#define INDICE(hash, capacidad) \
+  ((unsigned)((hash) * 2654435769u) >> (32 - __builtin_ctz(capacidad)))
+#define MEZCLA(hash) ((unsigned)((hash) * 2654435769u))
+#endif
 
 typedef void (*FuncionVisitanteExtra)(void *dato, void *extra);
 
@@ -16,13 +34,18 @@ typedef enum {
  * Estructura del nodo del arbol AVL.
  * Tiene un puntero al dato (dato),
  * un puntero al nodo raiz del subarbol izquierdo (izq),
- * un puntero al nodo raiz del subarbol derecho (der), y
- * un entero para representar la altura del arbol (altura)
+ * un puntero al nodo raiz del subarbol derecho (der),
+ * un entero para representar la altura del arbol (altura), y
+ * el valor de la funcion hash para el dato (hash), que ocupa el relleno que
+ * dejaba altura, asi que el nodo no crece.
+ * Los nodos se ordenan primero por hash y, solo entre hashes iguales, con la
+ * funcion comparadora: asi la mayoria de las comparaciones no la llaman.
  */
 typedef struct _AVL_Nodo {
   void* dato;
   struct _AVL_Nodo* izq, * der;
   int altura;
+  unsigned hash;
 } AVL_Nodo;
 
 /**
@@ -78,21 +101,34 @@ void avl_destruir(AVL arbol){
   free(arbol);
 }
 
+/**
+ * avl_nodo_comparar: Funcion interna que compara el nodo con el dato de hash
+ * dado. Solo llama a la funcion comparadora si los hashes coinciden.
+ */
+static int avl_nodo_comparar(AVL_Nodo* raiz, FuncionComparadora comp, void* dato,
+                             unsigned hash){
+  if (raiz->hash != hash)
+    return (raiz->hash > hash) ? 1 : -1;
+  return comp(raiz->dato, dato);
+}
+
 /**
  * Retorna 1 si el dato se encuentra y 0 en caso contrario
  */
-static int avl_nodo_buscar(AVL_Nodo* raiz, FuncionComparadora comp, void* dato){
+static int avl_nodo_buscar(AVL_Nodo* raiz, FuncionComparadora comp, void* dato,
+                           unsigned hash){
   if (raiz == NULL)
     return 0;
-  else if (comp(raiz->dato, dato) == 0)
+  int c = avl_nodo_comparar(raiz, comp, dato, hash);
+  if (c == 0)
     return 1;
-  else if (comp(raiz->dato, dato) > 0)
-    return avl_nodo_buscar(raiz->izq, comp, dato);
+  else if (c > 0)
+    return avl_nodo_buscar(raiz->izq, comp, dato, hash);
   else
-    return avl_nodo_buscar(raiz->der, comp, dato);
+    return avl_nodo_buscar(raiz->der, comp, dato, hash);
 }
-int avl_buscar(AVL arbol, void * dato){
-  return avl_nodo_buscar(arbol->raiz, arbol->comp, dato);
+int avl_buscar(AVL arbol, void * dato, unsigned hash){
+  return avl_nodo_buscar(arbol->raiz, arbol->comp, dato, hash);
 }
 
 /**
@@ -183,22 +219,24 @@ void avl_balancear(AVL arbol){
  * Inserta un dato no repetido en el arbol, manteniendo la propiedad de los
  * arboles AVL.
  */
-static AVL_Nodo* avl_nodo_crear(void* dato, FuncionCopiadora copy){
+static AVL_Nodo* avl_nodo_crear(void* dato, unsigned hash, FuncionCopiadora copy){
   AVL_Nodo* nuevo_nodo = malloc(sizeof(AVL_Nodo));
   assert(nuevo_nodo);
   nuevo_nodo->dato = copy(dato);
+  nuevo_nodo->hash = hash;
   nuevo_nodo->altura = 0;
   nuevo_nodo->der = nuevo_nodo->izq =  NULL;
   return nuevo_nodo;
 }
-static AVL_Nodo* avl_nodo_insertar(AVL_Nodo* raiz, void* dato, 
+static AVL_Nodo* avl_nodo_insertar(AVL_Nodo* raiz, void* dato, unsigned hash,
   FuncionComparadora comp, FuncionCopiadora copy){
     if (raiz == NULL)
-      return avl_nodo_crear(dato, copy);
-    else if (comp(raiz->dato,dato) > 0)
-      raiz->izq = avl_nodo_insertar(raiz->izq, dato, comp, copy);
-    else if (comp(raiz->dato, dato) < 0)
-      raiz->der = avl_nodo_insertar(raiz->der, dato, comp, copy);
+      return avl_nodo_crear(dato, hash, copy);
+    int c = avl_nodo_comparar(raiz, comp, dato, hash);
+    if (c > 0)
+      raiz->izq = avl_nodo_insertar(raiz->izq, dato, hash, comp, copy);
+    else if (c < 0)
+      raiz->der = avl_nodo_insertar(raiz->der, dato, hash, comp, copy);
     else
       return raiz;
     
@@ -206,24 +244,24 @@ static AVL_Nodo* avl_nodo_insertar(AVL_Nodo* raiz, void* dato,
     
     return avl_balancear_arbol(raiz);
 }
-void avl_insertar(AVL arbol, void *dato){
-  arbol->raiz = avl_nodo_insertar(arbol->raiz, dato, arbol->comp, arbol->copia);
+void avl_insertar(AVL arbol, void *dato, unsigned hash){
+  arbol->raiz = avl_nodo_insertar(arbol->raiz, dato, hash, arbol->comp, arbol->copia);
 }
 
 /**
  * Retorna 1 si el arbol cumple la propiedad de los arboles AVL, y 0 en caso
  * contrario.
  */
-static int avl_validar_abb(AVL_Nodo* raiz, FuncionComparadora comp, void* min, void* max){
+static int avl_validar_abb(AVL_Nodo* raiz, FuncionComparadora comp, AVL_Nodo* min, AVL_Nodo* max){
   if (raiz == NULL)
     return 1;
   else
   {
-    if (min != NULL && comp(raiz->dato, min) <= 0)
+    if (min != NULL && avl_nodo_comparar(raiz, comp, min->dato, min->hash) <= 0)
       return 0;
-    if (max != NULL && comp(raiz->dato, max) >= 0)
+    if (max != NULL && avl_nodo_comparar(raiz, comp, max->dato, max->hash) >= 0)
       return 0;
-    return (avl_validar_abb(raiz->izq, comp, min, raiz->dato)) && (avl_validar_abb(raiz->der, comp, raiz->dato, max));
+    return (avl_validar_abb(raiz->izq, comp, min, raiz)) && (avl_validar_abb(raiz->der, comp, raiz, max));
   }
 }
 static int avl_validar_altura_balance(AVL_Nodo* raiz){
@@ -274,13 +312,27 @@ static AVL_Nodo* avl_min(AVL_Nodo* raiz){
     return raiz;
   return avl_min(raiz->izq);
 }
-static AVL_Nodo* avl_nodo_eliminar(AVL_Nodo* raiz, void* dato, FuncionComparadora comp, FuncionDestructora destr){
+static AVL_Nodo* avl_nodo_eliminar_min(AVL_Nodo* raiz, FuncionDestructora destr){
+  if (raiz->izq == NULL)
+  {
+    AVL_Nodo* temp = raiz->der;
+    destr(raiz->dato);
+    free(raiz);
+    return temp;
+  }
+  raiz->izq = avl_nodo_eliminar_min(raiz->izq, destr);
+  raiz->altura = 1 + avl_nodo_max_altura_hijos(raiz);
+  return avl_balancear_arbol(raiz);
+}
+static AVL_Nodo* avl_nodo_eliminar(AVL_Nodo* raiz, void* dato, unsigned hash,
+                                   FuncionComparadora comp, FuncionDestructora destr){
   if (raiz == NULL )
     return NULL;
-  else if (comp(raiz->dato, dato) > 0)
-    raiz->izq = avl_nodo_eliminar(raiz->izq, dato, comp, destr);
-  else if (comp(raiz->dato,dato) < 0)
-    raiz->der = avl_nodo_eliminar(raiz->der, dato, comp, destr);
+  int c = avl_nodo_comparar(raiz, comp, dato, hash);
+  if (c > 0)
+    raiz->izq = avl_nodo_eliminar(raiz->izq, dato, hash, comp, destr);
+  else if (c < 0)
+    raiz->der = avl_nodo_eliminar(raiz->der, dato, hash, comp, destr);
   else{
     if (!raiz->izq || !raiz->der)
     {
@@ -293,84 +345,200 @@ static AVL_Nodo* avl_nodo_eliminar(AVL_Nodo* raiz, void* dato, FuncionComparador
     {
       AVL_Nodo* sucesor = avl_min(raiz->der);
       void* dato_temp = raiz->dato;
+      unsigned hash_temp = raiz->hash;
       raiz->dato = sucesor->dato;
+      raiz->hash = sucesor->hash;
       sucesor->dato = dato_temp;
-      raiz->der = avl_nodo_eliminar(raiz->der, sucesor->dato, comp, destr);
+      sucesor->hash = hash_temp;
+      // El sucesor es el minimo del subarbol derecho: se lo elimina bajando
+      // siempre a izquierda, sin comparar.
+      raiz->der = avl_nodo_eliminar_min(raiz->der, destr);
     }
   }
+  raiz->altura = 1 + avl_nodo_max_altura_hijos(raiz);
   return avl_balancear_arbol(raiz);
 }
-AVL avl_eliminar(AVL arbol, void* dato){
-  arbol->raiz = avl_nodo_eliminar(arbol->raiz, dato, arbol->comp, arbol->destr);
+AVL avl_eliminar(AVL arbol, void* dato, unsigned hash){
+  arbol->raiz = avl_nodo_eliminar(arbol->raiz, dato, hash, arbol->comp, arbol->destr);
   return arbol;
 }
 
+/**
+ * avl_extraer_min: quita del arbol el nodo con el menor dato, sin destruirlo,
+ * y lo retorna (o NULL si el arbol es vacio).
+ */
+static AVL_Nodo* avl_nodo_extraer_min(AVL_Nodo* raiz, AVL_Nodo** min){
+  if (raiz->izq == NULL)
+  {
+    *min = raiz;
+    return raiz->der;
+  }
+  raiz->izq = avl_nodo_extraer_min(raiz->izq, min);
+  raiz->altura = 1 + avl_nodo_max_altura_hijos(raiz);
+  return avl_balancear_arbol(raiz);
+}
+static AVL_Nodo* avl_extraer_min(AVL arbol){
+  AVL_Nodo* min = NULL;
+  if (arbol->raiz != NULL)
+    arbol->raiz = avl_nodo_extraer_min(arbol->raiz, &min);
+  return min;
+}
+
+/**
+ * avl_insertar_nodo: inserta en el arbol un nodo ya creado, cuyo dato no
+ * estaba en el arbol, sin volver a copiar el dato.
+ */
+static AVL_Nodo* avl_nodo_insertar_nodo(AVL_Nodo* raiz, AVL_Nodo* nodo, FuncionComparadora comp) {
+    if (!raiz) {
+        nodo->izq = nodo->der = NULL;
+        nodo->altura = 0;
+        return nodo;
+    }
+    if (avl_nodo_comparar(raiz, comp, nodo->dato, nodo->hash) > 0)
+        raiz->izq = avl_nodo_insertar_nodo(raiz->izq, nodo, comp);
+    else
+        raiz->der = avl_nodo_insertar_nodo(raiz->der, nodo, comp);
+    raiz->altura = 1 + avl_nodo_max_altura_hijos(raiz);
+    return avl_balancear_arbol(raiz);
+}
+
 /**
  * avl_obtener_dato: retorna el puntero del dato que se busca
  */
-static void* avl_nodo_obtener(AVL_Nodo* raiz, FuncionComparadora comp, void* dato){
+static AVL_Nodo* avl_nodo_obtener(AVL_Nodo* raiz, FuncionComparadora comp, void* dato,
+                                  unsigned hash, unsigned* sondeos){
   if (raiz == NULL)
     return NULL;
-  else if (comp(raiz->dato, dato) == 0)
-    return raiz->dato;
-  else if (comp(raiz->dato, dato) > 0)
-    return avl_nodo_obtener(raiz->izq, comp, dato);
+  CONTAR(sondeos, 1);
+  int c = avl_nodo_comparar(raiz, comp, dato, hash);
+  if (c == 0)
+    return raiz;
+  else if (c > 0)
+    return avl_nodo_obtener(raiz->izq, comp, dato, hash, sondeos);
   else
-    return avl_nodo_obtener(raiz->der, comp, dato);
+    return avl_nodo_obtener(raiz->der, comp, dato, hash, sondeos);
 }
-void* avl_obtener(AVL arbol, void * dato){
-  return avl_nodo_obtener(arbol->raiz, arbol->comp, dato);
+void* avl_obtener(AVL arbol, void * dato, unsigned hash){
+  AVL_Nodo* nodo = avl_nodo_obtener(arbol->raiz, arbol->comp, dato, hash, NULL);
+  return (nodo != NULL) ? nodo->dato : NULL;
 }
 
 
-//IMPLEMENTACION DE TABLA HASH CON ENCADENAMIENTO DE ESTRUCTURA AUXILIAR (AVL).//
+//IMPLEMENTACION DE TABLA HASH CON ENCADENAMIENTO EN CUBETAS PLANAS (DESBORDE EN AVL).//
+/**
+ * Cubeta de la tabla hash. Guarda hasta TAM_CUBETA datos (con sus hashes) en
+ * un arreglo que ocupa, junto con el resto de la cubeta, una linea de cache.
+ * Solo cuando la cubeta se llena, los datos siguientes van a un arbol AVL de
+ * desborde, que mantiene el costo O(log n) en el peor caso.
+ * Los datos del arreglo ocupan siempre las primeras num posiciones, y el
+ * desborde solo tiene datos si el arreglo esta lleno.
+ */
+#define TAM_CUBETA 4
+typedef struct {
+  void *datos[TAM_CUBETA];
+  unsigned hashes[TAM_CUBETA];
+  unsigned num;
+  AVL desborde;
+} Cubeta;
+
 /**
  * Casillas en la que almacenaremos los datos de la tabla hash.
+ * La cubeta se pide recien al insertar el primer dato de la casilla, y se
+ * libera cuando queda vacia.
  */
 typedef struct {
-  AVL casilla;
+  Cubeta *cubeta;
 } CasillaHash;
 
 /**
  * Estructura principal que representa la tabla hash.
+ * Durante una redimension incremental, elemsViejos guarda el arreglo anterior
+ * (de capacidadVieja casillas), del cual ya se migraron las primeras
+ * migradas casillas. Fuera de una redimension, elemsViejos es NULL.
  */
 struct _TablaHash {
   CasillaHash *elems;
   unsigned numElems;
   unsigned capacidad;
+  CasillaHash *elemsViejos;
+  unsigned capacidadVieja;
+  unsigned migradas;
+  unsigned pasos;
   FuncionCopiadora copia;
   FuncionComparadora comp;
   FuncionDestructora destr;
   FuncionHash hash;
+  TablaHashOpciones opciones;
+  CONTADORES_CAMPO
 };
 
 /**
- * Crea una nueva tabla hash vacia, con la capacidad dada.
+ * Pide memoria para un arreglo de casillas sin cubetas. Se pide en cero, como
+ * en tablahashlp.c, para que crear el arreglo nuevo de una redimension
+ * incremental no lo recorra entero.
  */
-TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
-                          FuncionComparadora comp, FuncionDestructora destr,
-                          FuncionHash hash) {
+static CasillaHash *tablahash_casillas_crear(unsigned capacidad) {
+  CasillaHash *elems = calloc(capacidad, sizeof(CasillaHash));
+  assert(elems != NULL);
+  return elems;
+}
+
+/**
+ * Retorna la capacidad con la que se crea realmente la tabla: sin
+ * TABLAHASH_MODULO, la menor potencia de dos (al menos 2) mayor o igual a la
+ * pedida.
+ */
+static unsigned tablahash_capacidad_real(unsigned capacidad) {
+#ifdef TABLAHASH_MODULO
+  return capacidad;
+#else
+  unsigned real = 2;
+  while (real < capacidad)
+    real *= 2;
+  return real;
+#endif
+}
+
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad y las opciones dadas.
+ */
+TablaHash tablahash_crear_con_opciones(unsigned capacidad, FuncionCopiadora copia,
+                                       FuncionComparadora comp,
+                                       FuncionDestructora destr, FuncionHash hash,
+                                       const TablaHashOpciones *opciones) {
 
   // Pedimos memoria para la estructura principal y las casillas.
   TablaHash tabla = malloc(sizeof(struct _TablaHash));
   assert(tabla != NULL);
-  tabla->elems = malloc(sizeof(CasillaHash) * capacidad);
-  assert(tabla->elems != NULL);
+  tabla->opciones = tablahash_opciones_completar(opciones, LIMITE, 0);
+  if (capacidad < tabla->opciones.capacidadMinima)
+    capacidad = tabla->opciones.capacidadMinima;
+  capacidad = tablahash_capacidad_real(capacidad);
+  tabla->elems = tablahash_casillas_crear(capacidad);
   tabla->numElems = 0;
   tabla->capacidad = capacidad;
+  tabla->elemsViejos = NULL;
+  tabla->capacidadVieja = 0;
+  tabla->migradas = 0;
+  tabla->pasos = 0;
   tabla->copia = copia;
   tabla->comp = comp;
   tabla->destr = destr;
   tabla->hash = hash;
-
-  // Inicializamos las casillas con datos nulos.
-  for (unsigned idx = 0; idx < capacidad; ++idx) {
-    tabla->elems[idx].casilla = avl_crear(copia, comp, destr);
-  }
+  CONTADORES_INICIAR(tabla);
 
   return tabla;
 }
 
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad dada.
+ */
+TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
+                          FuncionComparadora comp, FuncionDestructora destr,
+                          FuncionHash hash) {
+  return tablahash_crear_con_opciones(capacidad, copia, comp, destr, hash, NULL);
+}
+
 /**
  * Retorna el numero de elementos de la tabla.
  */
@@ -384,136 +552,621 @@ int tablahash_capacidad(TablaHash tabla) { return tabla->capacidad; }
 /**
  * Destruye la tabla.
  */
-void tablahash_destruir(TablaHash tabla) {
-
+static void cubeta_destruir(Cubeta *cubeta, FuncionDestructora destr) {
+  for (unsigned i = 0; i < cubeta->num; ++i)
+    destr(cubeta->datos[i]);
+  if (cubeta->desborde != NULL)
+    avl_destruir(cubeta->desborde);
+  free(cubeta);
+}
+static void tablahash_casillas_destruir(CasillaHash *elems, unsigned capacidad,
+                                        FuncionDestructora destr) {
   // Destruir cada uno de los datos.
-  for (unsigned idx = 0; idx < tabla->capacidad; ++idx){
-    if (tabla->elems[idx].casilla != NULL)
-      avl_destruir(tabla->elems[idx].casilla);
+  for (unsigned idx = 0; idx < capacidad; ++idx){
+    if (elems[idx].cubeta != NULL)
+      cubeta_destruir(elems[idx].cubeta, destr);
   }
-  // Liberar el arreglo de casillas y la tabla.
-  free(tabla->elems);
+  free(elems);
+}
+void tablahash_destruir(TablaHash tabla) {
+  tablahash_casillas_destruir(tabla->elems, tabla->capacidad, tabla->destr);
+  if (tabla->elemsViejos != NULL)
+    tablahash_casillas_destruir(tabla->elemsViejos, tabla->capacidadVieja, tabla->destr);
+  // Liberar la tabla.
   free(tabla);
 }
 
+/**
+ * Retorna la posicion del dato en el arreglo de la cubeta, o -1 si no esta
+ * alli.
+ */
+static int cubeta_posicion(Cubeta *cubeta, FuncionComparadora comp, void *dato,
+                           unsigned hash) {
+  for (unsigned i = 0; i < cubeta->num; ++i)
+    if (cubeta->hashes[i] == hash && comp(cubeta->datos[i], dato) == 0)
+      return i;
+  return -1;
+}
+
+/**
+ * Retorna el dato de la cubeta que coincida con el dato dado, o NULL.
+ * Suma a sondeos (si no es NULL) los datos del arreglo y los nodos del
+ * desborde que se revisaron.
+ */
+static void *cubeta_buscar(Cubeta *cubeta, FuncionComparadora comp, void *dato,
+                           unsigned hash, unsigned *sondeos) {
+  if (cubeta == NULL)
+    return NULL;
+  int pos = cubeta_posicion(cubeta, comp, dato, hash);
+  CONTAR(sondeos, (pos != -1) ? (unsigned)pos + 1 : cubeta->num);
+  if (pos != -1)
+    return cubeta->datos[pos];
+  if (cubeta->desborde != NULL) {
+    AVL_Nodo *nodo = avl_nodo_obtener(cubeta->desborde->raiz, comp, dato, hash,
+                                      sondeos);
+    return (nodo != NULL) ? nodo->dato : NULL;
+  }
+  return NULL;
+}
+
+/**
+ * Agrega a la casilla un dato que no estaba en ella, sin copiarlo.
+ */
+static void casilla_colocar(TablaHash tabla, CasillaHash *casilla, void *dato,
+                            unsigned hash) {
+  if (casilla->cubeta == NULL) {
+    casilla->cubeta = aligned_alloc(64, sizeof(Cubeta));
+    assert(casilla->cubeta != NULL);
+    casilla->cubeta->num = 0;
+    casilla->cubeta->desborde = NULL;
+  }
+  Cubeta *cubeta = casilla->cubeta;
+  if (cubeta->num < TAM_CUBETA) {
+    cubeta->datos[cubeta->num] = dato;
+    cubeta->hashes[cubeta->num] = hash;
+    cubeta->num++;
+    return;
+  }
+  // La cubeta esta llena: el dato va al arbol de desborde.
+  if (cubeta->desborde == NULL)
+    cubeta->desborde = avl_crear(tabla->copia, tabla->comp, tabla->destr);
+  AVL_Nodo *nodo = malloc(sizeof(AVL_Nodo));
+  assert(nodo);
+  nodo->dato = dato;
+  nodo->hash = hash;
+  cubeta->desborde->raiz =
+      avl_nodo_insertar_nodo(cubeta->desborde->raiz, nodo, tabla->comp);
+}
+
+/**
+ * Reemplaza por una copia del dato dado el dato de la casilla que coincida con
+ * el. Retorna 1 si lo encontro y 0 en caso contrario.
+ */
+static int casilla_reemplazar(TablaHash tabla, CasillaHash *casilla, void *dato,
+                              unsigned hash) {
+  Cubeta *cubeta = casilla->cubeta;
+  if (cubeta == NULL)
+    return 0;
+  void **lugar = NULL;
+  int pos = cubeta_posicion(cubeta, tabla->comp, dato, hash);
+  if (pos != -1)
+    lugar = &cubeta->datos[pos];
+  else if (cubeta->desborde != NULL) {
+    AVL_Nodo *nodo = avl_nodo_obtener(cubeta->desborde->raiz, tabla->comp, dato, hash,
+                                      NULL);
+    if (nodo != NULL)
+      lugar = &nodo->dato;
+  }
+  if (lugar == NULL)
+    return 0;
+  tabla->destr(*lugar);
+  *lugar = tabla->copia(dato);
+  return 1;
+}
+
+/**
+ * Elimina de la casilla el dato que coincida con el dato dado. Retorna 1 si lo
+ * encontro y 0 en caso contrario.
+ */
+static int casilla_eliminar(TablaHash tabla, CasillaHash *casilla, void *dato,
+                            unsigned hash) {
+  Cubeta *cubeta = casilla->cubeta;
+  if (cubeta == NULL)
+    return 0;
+  int pos = cubeta_posicion(cubeta, tabla->comp, dato, hash);
+  if (pos != -1) {
+    tabla->destr(cubeta->datos[pos]);
+    // Tapamos el hueco con el ultimo dato del arreglo, y este con un dato del
+    // desborde si lo hay.
+    cubeta->num--;
+    cubeta->datos[pos] = cubeta->datos[cubeta->num];
+    cubeta->hashes[pos] = cubeta->hashes[cubeta->num];
+    if (cubeta->desborde != NULL) {
+      AVL_Nodo *nodo = avl_extraer_min(cubeta->desborde);
+      cubeta->datos[cubeta->num] = nodo->dato;
+      cubeta->hashes[cubeta->num] = nodo->hash;
+      cubeta->num++;
+      free(nodo);
+    }
+  }
+  else if (cubeta->desborde != NULL && avl_buscar(cubeta->desborde, dato, hash))
+    avl_eliminar(cubeta->desborde, dato, hash);
+  else
+    return 0;
+
+  if (cubeta->desborde != NULL && cubeta->desborde->raiz == NULL) {
+    free(cubeta->desborde);
+    cubeta->desborde = NULL;
+  }
+  if (cubeta->num == 0) {
+    free(cubeta);
+    casilla->cubeta = NULL;
+  }
+  return 1;
+}
+
+/**
+ * Mueve todos los datos de una cubeta a la tabla, sin copiarlos ni volver a
+ * llamar a la funcion hash, y libera la cubeta.
+ */
+static void tablahash_mover_nodos(TablaHash tabla, AVL_Nodo* raiz) {
+  if (raiz == NULL)
+    return;
+  tablahash_mover_nodos(tabla, raiz->izq);
+  tablahash_mover_nodos(tabla, raiz->der);
+  casilla_colocar(tabla, &tabla->elems[INDICE(raiz->hash, tabla->capacidad)],
+                  raiz->dato, raiz->hash);
+  free(raiz);
+}
+static void tablahash_mover_cubeta(TablaHash tabla, Cubeta *cubeta) {
+  for (unsigned i = 0; i < cubeta->num; ++i)
+    casilla_colocar(tabla, &tabla->elems[INDICE(cubeta->hashes[i], tabla->capacidad)],
+                    cubeta->datos[i], cubeta->hashes[i]);
+  if (cubeta->desborde != NULL) {
+    tablahash_mover_nodos(tabla, cubeta->desborde->raiz);
+    free(cubeta->desborde);
+  }
+  free(cubeta);
+}
+
+/**
+ * Migra a lo sumo n casillas del arreglo anterior al nuevo, sin copiar los
+ * datos. Cuando termina de migrar, libera el arreglo anterior.
+ */
+static void tablahash_migrar(TablaHash tabla, unsigned n) {
+  if (tabla->elemsViejos == NULL)
+    return;
+  RELOJ_INICIAR(inicio);
+  for (; n > 0 && tabla->migradas < tabla->capacidadVieja; n--, tabla->migradas++) {
+    CasillaHash *vieja = &tabla->elemsViejos[tabla->migradas];
+    if (vieja->cubeta != NULL) {
+      tablahash_mover_cubeta(tabla, vieja->cubeta);
+      vieja->cubeta = NULL;
+    }
+  }
+  if (tabla->migradas == tabla->capacidadVieja) {
+    free(tabla->elemsViejos);
+    tabla->elemsViejos = NULL;
+    tabla->capacidadVieja = 0;
+    tabla->migradas = 0;
+  }
+  RELOJ_DETENER(tabla, inicio);
+}
+
+/**
+ * Reemplaza el arreglo de casillas por uno de la capacidad dada y deja el
+ * anterior pendiente de migrar.
+ */
+static void tablahash_iniciar_migracion(TablaHash tabla, unsigned capacidad) {
+  assert(tabla->elemsViejos == NULL);
+  RELOJ_INICIAR(inicio);
+  REGISTRAR_REDIMENSION(tabla);
+  tabla->elemsViejos = tabla->elems;
+  tabla->capacidadVieja = tabla->capacidad;
+  tabla->migradas = 0;
+  tabla->capacidad = capacidad;
+  tabla->elems = tablahash_casillas_crear(tabla->capacidad);
+  RELOJ_DETENER(tabla, inicio);
+}
+
+/**
+ * Cambia la capacidad de la tabla (redondeada a una potencia de dos), despues
+ * de completar la migracion pendiente si la hay. Con la redimension
+ * incremental activa, la migracion al nuevo arreglo queda pendiente.
+ */
+static void tablahash_redimensionar_a(TablaHash tabla, unsigned capacidad) {
+  tablahash_migrar(tabla, tabla->capacidadVieja);
+  tablahash_iniciar_migracion(tabla, tablahash_capacidad_real(capacidad));
+  if (tabla->pasos == 0)
+    tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Agranda la tabla de una vez para que entren n datos sin redimensionar.
+ */
+void tablahash_reservar(TablaHash tabla, unsigned n) {
+  unsigned capacidad = tablahash_capacidad_para(&tabla->opciones, n);
+  if (tablahash_capacidad_real(capacidad) <= tabla->capacidad)
+    return;
+  tablahash_redimensionar_a(tabla, capacidad);
+  tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Activa la redimension incremental, migrando a lo sumo pasos casillas por
+ * operacion.
+ */
+void tablahash_redimension_incremental(TablaHash tabla, unsigned pasos) {
+  tabla->pasos = pasos;
+  if (pasos == 0)
+    tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Retorna la casilla del arreglo anterior en la que podria estar el dato, o
+ * NULL si no hay redimension en curso.
+ */
+static CasillaHash *tablahash_casilla_vieja(TablaHash tabla, unsigned hash) {
+  if (tabla->elemsViejos == NULL)
+    return NULL;
+  return &tabla->elemsViejos[INDICE(hash, tabla->capacidadVieja)];
+}
+
 /**
  * Inserta un dato en la tabla, o lo reemplaza si ya se encontraba.
  */
-void tablahash_insertar(TablaHash tabla, void *dato) {
-  if(FACTOR_CARGA(tabla->numElems,tabla->capacidad) >= LIMITE)
-    tablahash_redimensionar(tabla);
+void tablahash_insertar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  tablahash_migrar(tabla, tabla->pasos);
+  if(FACTOR_CARGA(tabla->numElems,tabla->capacidad) >= tabla->opciones.cargaMaxima)
+    tablahash_redimensionar_a(tabla, tablahash_capacidad_crecida(&tabla->opciones,
+                                                                 tabla->capacidad));
   // Calculamos la posicion del dato dado, de acuerdo a la funcion hash.
-  unsigned idx = tabla->hash(dato) % tabla->capacidad;
-  AVL casilla = tabla->elems[idx].casilla;
-  
-  if (avl_buscar(casilla,dato))//verificar si hay colision.
-  {
-    avl_eliminar(casilla,dato);
+  CasillaHash *casilla = &tabla->elems[INDICE(hash, tabla->capacidad)];
+  CasillaHash *vieja = tablahash_casilla_vieja(tabla, hash);
+
+  if (casilla_reemplazar(tabla, casilla, dato, hash))//si ya estaba, se reemplaza.
+    return;
+  if (vieja != NULL && casilla_eliminar(tabla, vieja, dato, hash))//si sigue en el arreglo anterior.
     tabla->numElems--;
-  }
 
-  avl_insertar(casilla,dato);
+  casilla_colocar(tabla, casilla, tabla->copia(dato), hash);
   tabla->numElems++;
 }
+void tablahash_insertar(TablaHash tabla, void *dato) {
+  tablahash_insertar_hash(tabla, dato, tabla->hash(dato));
+}
 
 /**
  * Retorna el dato de la tabla que coincida con el dato dado, o NULL si el dato
  * buscado no se encuentra en la tabla.
  */
-void *tablahash_buscar(TablaHash tabla, void *dato) {
+void *tablahash_buscar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  tablahash_migrar(tabla, tabla->pasos);
 
   // Calculamos la posicion del dato dado, de acuerdo a la funcion hash.
-  unsigned idx = tabla->hash(dato) % tabla->capacidad;
-  AVL casilla = tabla->elems[idx].casilla;
+  Cubeta *cubeta = tabla->elems[INDICE(hash, tabla->capacidad)].cubeta;
   // Retornar el dato de la casilla si hay concidencia.
-  return avl_obtener(casilla,dato);
+  unsigned sondeos = 0;
+  void *encontrado = cubeta_buscar(cubeta, tabla->comp, dato, hash, &sondeos);
+  // Mientras dure la migracion, el dato puede seguir en el arreglo anterior.
+  CasillaHash *vieja = tablahash_casilla_vieja(tabla, hash);
+  if (encontrado == NULL && vieja != NULL)
+    encontrado = cubeta_buscar(vieja->cubeta, tabla->comp, dato, hash, &sondeos);
+  REGISTRAR_BUSQUEDA(tabla, sondeos, encontrado != NULL);
+  return encontrado;
+}
+void *tablahash_buscar(TablaHash tabla, void *dato) {
+  return tablahash_buscar_hash(tabla, dato, tabla->hash(dato));
+}
+
+/**
+ * Calcula los hashes de un lote de a lo sumo TAM_LOTE datos y adelanta la
+ * carga de sus casillas en dos pasadas: primero el puntero a la cubeta de cada
+ * casilla, y despues la cubeta.
+ */
+static void tablahash_preparar_lote(TablaHash tabla, void **datos, size_t n,
+                                    unsigned *hashes) {
+  for (size_t i = 0; i < n; i++) {
+    hashes[i] = tabla->hash(datos[i]);
+    __builtin_prefetch(&tabla->elems[INDICE(hashes[i], tabla->capacidad)]);
+  }
+  for (size_t i = 0; i < n; i++) {
+    Cubeta *cubeta = tabla->elems[INDICE(hashes[i], tabla->capacidad)].cubeta;
+    if (cubeta != NULL)
+      __builtin_prefetch(cubeta);
+  }
+}
+
+/**
+ * Busca n datos de una vez, de a lotes de TAM_LOTE.
+ */
+void tablahash_buscar_lote(TablaHash tabla, void **claves, size_t n,
+                           void **resultados) {
+  unsigned hashes[TAM_LOTE];
+  for (size_t inicio = 0; inicio < n; inicio += TAM_LOTE) {
+    size_t lote = (n - inicio < TAM_LOTE) ? n - inicio : TAM_LOTE;
+    tablahash_preparar_lote(tabla, &claves[inicio], lote, hashes);
+    for (size_t i = 0; i < lote; i++)
+      resultados[inicio + i] = tablahash_buscar_hash(tabla, claves[inicio + i], hashes[i]);
+  }
+}
+
+/**
+ * Inserta n datos de una vez, de a lotes de TAM_LOTE.
+ */
+void tablahash_insertar_lote(TablaHash tabla, void **datos, size_t n) {
+  unsigned hashes[TAM_LOTE];
+  for (size_t inicio = 0; inicio < n; inicio += TAM_LOTE) {
+    size_t lote = (n - inicio < TAM_LOTE) ? n - inicio : TAM_LOTE;
+    tablahash_preparar_lote(tabla, &datos[inicio], lote, hashes);
+    for (size_t i = 0; i < lote; i++)
+      tablahash_insertar_hash(tabla, datos[inicio + i], hashes[i]);
+  }
 }
 
 /**
  * Elimina el dato de la tabla que coincida con el dato dado.
  */
+void tablahash_eliminar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  tablahash_migrar(tabla, tabla->pasos);
+
+  // Calculamos la posicion del dato dado, de acuerdo a su hash.
+  CasillaHash *casilla = &tabla->elems[INDICE(hash, tabla->capacidad)];
+  CasillaHash *vieja = tablahash_casilla_vieja(tabla, hash);
+  if (!casilla_eliminar(tabla, casilla, dato, hash) &&//en caso de encontrarse el dato en la tabla.
+      (vieja == NULL || !casilla_eliminar(tabla, vieja, dato, hash)))
+    return;
+  tabla->numElems--;
+
+  // Si quedo por debajo de la carga minima, achicamos la tabla.
+  unsigned capacidad = tablahash_capacidad_real(tablahash_capacidad_achicada(
+      &tabla->opciones, tabla->numElems, tabla->capacidad));
+  if (capacidad < tabla->capacidad)
+    tablahash_redimensionar_a(tabla, capacidad);
+}
 void tablahash_eliminar(TablaHash tabla, void *dato) {
+  tablahash_eliminar_hash(tabla, dato, tabla->hash(dato));
+}
 
-  // Calculamos la posicion del dato dado, de acuerdo a la funcion hash.
-  unsigned idx = tabla->hash(dato) % tabla->capacidad;
-  AVL casilla=tabla->elems[idx].casilla;
-  if (avl_buscar(casilla,dato))//en caso de encontrarse el dato en la tabla.
-  {
-    avl_eliminar(casilla,dato);
-    tabla->numElems--;
+/**
+ * Multiplica la capacidad de la tabla por el factor de crecimiento y reposiciona todos los
+ * elementos de acuerdo a la nueva posicion que le asigne la funcion de hash.
+ */
+void tablahash_redimensionar(TablaHash tabla) {
+    //Reubico todos los elementos en un arreglo de mayor capacidad.
+    tablahash_redimensionar_a(tabla, tablahash_capacidad_crecida(&tabla->opciones,
+                                                                 tabla->capacidad));
+    tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Recorre un arreglo de casillas acumulando sus estadisticas estructurales.
+ * Los datos desbordados son los que estan en los arboles AVL; la busqueda
+ * exitosa mas larga recorre la cubeta llena y el camino mas largo del arbol.
+ */
+static void tablahash_estadisticas_aux(CasillaHash *elems, unsigned capacidad,
+                                       unsigned desde,
+                                       TablaHashEstadisticas *estadisticas) {
+  for (unsigned idx = desde; idx < capacidad; ++idx) {
+    Cubeta *cubeta = elems[idx].cubeta;
+    if (cubeta == NULL)
+      continue;
+    estadisticas->casillasUsadas++;
+    unsigned altura = 0;
+    if (cubeta->desborde != NULL)
+      altura = avl_nodo_altura(cubeta->desborde->raiz) + 1;
+    if (altura > estadisticas->alturaMaxima)
+      estadisticas->alturaMaxima = altura;
+    if (cubeta->num + altura > estadisticas->sondeoMaximo)
+      estadisticas->sondeoMaximo = cubeta->num + altura;
+    estadisticas->desbordados -= cubeta->num;
   }
+}
 
+/**
+ * Completa estadisticas con el estado actual de la tabla y, si esta
+ * instrumentada, con los contadores acumulados desde su creacion.
+ */
+void tablahash_estadisticas(TablaHash tabla, TablaHashEstadisticas *estadisticas) {
+  memset(estadisticas, 0, sizeof(TablaHashEstadisticas));
+  estadisticas->numElems = tabla->numElems;
+  estadisticas->capacidad = tabla->capacidad;
+  // Se parte de todos los datos y se descuentan los que estan en los arreglos.
+  estadisticas->desbordados = tabla->numElems;
+  tablahash_estadisticas_aux(tabla->elems, tabla->capacidad, 0, estadisticas);
+  if (tabla->elemsViejos != NULL)
+    tablahash_estadisticas_aux(tabla->elemsViejos, tabla->capacidadVieja,
+                               tabla->migradas, estadisticas);
+  contadores_volcar(tabla, estadisticas);
 }
+
 /**
- * Duplica la capacidad de la tabla y reposiciona todos los elementos de acuerdo a la nueva
- * posicion que le asigne la funcion de hash.
+ * Aplica visita a cada dato de un arreglo de casillas: primero los de cada
+ * cubeta y luego los de su arbol de desborde.
  */
-static void destr_sin_datos(AVL_Nodo* raiz){
-  if (raiz != NULL)
-  {
-    destr_sin_datos(raiz->izq);
-    destr_sin_datos(raiz->der);
-    free(raiz);
+static void tablahash_recorrer_aux(CasillaHash *elems, unsigned capacidad,
+                                   unsigned desde, FuncionVisitanteTabla visita,
+                                   void *extra) {
+  for (unsigned idx = desde; idx < capacidad; ++idx) {
+    Cubeta *cubeta = elems[idx].cubeta;
+    if (cubeta == NULL)
+      continue;
+    for (unsigned i = 0; i < cubeta->num; ++i)
+      visita(cubeta->datos[i], extra);
+    if (cubeta->desborde != NULL)
+      avl_recorrer(cubeta->desborde, AVL_RECORRIDO_IN, visita, extra);
   }
 }
-static void avl_insertar_sin_copiar(AVL arbol, void* dato);
-static AVL_Nodo* avl_nodo_insertar_sin_copiar(AVL_Nodo* raiz, void* dato, FuncionComparadora comp);
-static void tablahash_insertar_directo(TablaHash tabla, void* dato);
-static void reinsertar_sin_copiar(void* dato, void* extra);
 
-static void avl_insertar_sin_copiar(AVL arbol, void* dato) {
-    arbol->raiz = avl_nodo_insertar_sin_copiar(arbol->raiz, dato, arbol->comp);
-    avl_balancear(arbol);
+/**
+ * Aplica visita a cada dato de la tabla, incluidos los que todavia no se
+ * migraron del arreglo anterior.
+ */
+void tablahash_recorrer(TablaHash tabla, FuncionVisitanteTabla visita,
+                        void *extra) {
+  tablahash_recorrer_aux(tabla->elems, tabla->capacidad, 0, visita, extra);
+  if (tabla->elemsViejos != NULL)
+    tablahash_recorrer_aux(tabla->elemsViejos, tabla->capacidadVieja,
+                           tabla->migradas, visita, extra);
 }
-static AVL_Nodo* avl_nodo_insertar_sin_copiar(AVL_Nodo* raiz, void* dato, FuncionComparadora comp) {
-    if (!raiz) {
-        AVL_Nodo* nuevo = malloc(sizeof(AVL_Nodo));
-        nuevo->dato = dato;    
-        nuevo->izq = nuevo->der = NULL;
-        nuevo->altura = 0;
-        return nuevo;
+
+/**
+ * Altura maxima de los arboles de desborde que puede recorrer un iterador (un
+ * AVL de altura 64 tendria mas datos de los que caben en la tabla).
+ */
+#define ALTURA_ITER 64
+
+/**
+ * Estructura del iterador: recorre las casillas de elems y, al terminarlas,
+ * las del arreglo anterior que quedan por migrar. De cada cubeta da primero
+ * los datos del arreglo (desde posicion) y despues los del desborde en orden;
+ * pila guarda los nodos del desborde cuyo dato y subarbol derecho faltan.
+ */
+struct _TablaHashIter {
+  TablaHash tabla;
+  CasillaHash *elems;
+  unsigned capacidad;
+  unsigned idx;
+  unsigned posicion;
+  AVL_Nodo *pila[ALTURA_ITER];
+  unsigned tope;
+};
+
+/**
+ * Crea un iterador sobre los datos de la tabla.
+ */
+TablaHashIter tablahash_iter_crear(TablaHash tabla) {
+  TablaHashIter iter = malloc(sizeof(struct _TablaHashIter));
+  assert(iter != NULL);
+  iter->tabla = tabla;
+  iter->elems = tabla->elems;
+  iter->capacidad = tabla->capacidad;
+  iter->idx = 0;
+  iter->posicion = 0;
+  iter->tope = 0;
+  return iter;
+}
+
+/**
+ * Apila el nodo y sus descendientes por izquierda.
+ */
+static void tablahash_iter_apilar(TablaHashIter iter, AVL_Nodo *nodo) {
+  for (; nodo != NULL; nodo = nodo->izq) {
+    assert(iter->tope < ALTURA_ITER);
+    iter->pila[iter->tope++] = nodo;
+  }
+}
+
+/**
+ * Retorna el siguiente dato del iterador, o NULL si ya se recorrieron todos.
+ */
+void *tablahash_iter_siguiente(TablaHashIter iter) {
+  for (;;) {
+    // Primero, lo que falta del desborde de la ultima cubeta.
+    if (iter->tope > 0) {
+      AVL_Nodo *nodo = iter->pila[--iter->tope];
+      tablahash_iter_apilar(iter, nodo->der);
+      return nodo->dato;
     }
-    int c = comp(dato, raiz->dato);
-    if (c < 0)
-        raiz->izq = avl_nodo_insertar_sin_copiar(raiz->izq, dato, comp);
-    else if (c > 0)
-        raiz->der = avl_nodo_insertar_sin_copiar(raiz->der, dato, comp);
-    else {
-        // reemplazo: destruyo dato viejo y pongo nuevo puntero.
-        raiz->dato = dato;
+    if (iter->idx < iter->capacidad) {
+      Cubeta *cubeta = iter->elems[iter->idx].cubeta;
+      if (cubeta != NULL && iter->posicion < cubeta->num)
+        return cubeta->datos[iter->posicion++];
+      if (cubeta != NULL && cubeta->desborde != NULL)
+        tablahash_iter_apilar(iter, cubeta->desborde->raiz);
+      iter->idx++;
+      iter->posicion = 0;
+      continue;
     }
-    return raiz;
+    // Terminado el arreglo actual, seguimos con el anterior, si lo hay.
+    TablaHash tabla = iter->tabla;
+    if (iter->elems != tabla->elems || tabla->elemsViejos == NULL)
+      return NULL;
+    iter->elems = tabla->elemsViejos;
+    iter->capacidad = tabla->capacidadVieja;
+    iter->idx = tabla->migradas;
+  }
 }
-static void tablahash_insertar_directo(TablaHash tabla, void* dato) {
-    unsigned idx = tabla->hash(dato) % tabla->capacidad;
-    avl_insertar_sin_copiar(tabla->elems[idx].casilla, dato);
-    tabla->numElems++;
+
+/**
+ * Destruye el iterador.
+ */
+void tablahash_iter_destruir(TablaHashIter iter) {
+  free(iter);
 }
-static void reinsertar_sin_copiar(void* dato, void* extra) {
-    TablaHash tabla = extra;
-    tablahash_insertar_directo(tabla, dato);
+
+/**
+ * Aplica visita, en orden, a los datos del arbol cuyo hash mezclado esta entre
+ * desde y hasta.
+ */
+static void avl_nodo_escanear(AVL_Nodo *raiz, unsigned desde, unsigned hasta,
+                              FuncionVisitanteTabla visita, void *extra) {
+  if (raiz == NULL)
+    return;
+  avl_nodo_escanear(raiz->izq, desde, hasta, visita, extra);
+  if (MEZCLA(raiz->hash) >= desde && MEZCLA(raiz->hash) <= hasta)
+    visita(raiz->dato, extra);
+  avl_nodo_escanear(raiz->der, desde, hasta, visita, extra);
 }
-void tablahash_redimensionar(TablaHash tabla) {
-    unsigned cap_ant = tabla->capacidad;
-    CasillaHash* viejos = tabla->elems;
-
-    tabla->capacidad *= 2;
-    tabla->elems = malloc(sizeof(CasillaHash) * tabla->capacidad);
-    for (unsigned i = 0; i < tabla->capacidad; i++)
-        tabla->elems[i].casilla = avl_crear(tabla->copia, tabla->comp, tabla->destr);
-
-    unsigned num_ant = tabla->numElems;
-    tabla->numElems = 0;
-
-    for (unsigned i = 0; i < cap_ant; i++) {
-        if (viejos[i].casilla) {
-            avl_recorrer(viejos[i].casilla, AVL_RECORRIDO_IN, reinsertar_sin_copiar, tabla);
-            destr_sin_datos(viejos[i].casilla->raiz);
-            free(viejos[i].casilla);
-        }
+
+/**
+ * Aplica visita a los datos de las casillas de elems entre primera y ultima
+ * cuyo hash mezclado esta entre desde y hasta.
+ */
+static void tablahash_escanear_aux(CasillaHash *elems, unsigned primera,
+                                   unsigned ultima, unsigned desde,
+                                   unsigned hasta, FuncionVisitanteTabla visita,
+                                   void *extra) {
+  for (unsigned idx = primera; ; ++idx) {
+    Cubeta *cubeta = elems[idx].cubeta;
+    if (cubeta != NULL) {
+      for (unsigned i = 0; i < cubeta->num; ++i)
+        if (MEZCLA(cubeta->hashes[i]) >= desde && MEZCLA(cubeta->hashes[i]) <= hasta)
+          visita(cubeta->datos[i], extra);
+      if (cubeta->desborde != NULL)
+        avl_nodo_escanear(cubeta->desborde->raiz, desde, hasta, visita, extra);
     }
-    free(viejos);
-    // assert(tablahash_nelems(tabla) == num_ant);
+    if (idx == ultima)
+      return;
+  }
 }
 
-
+#ifdef TABLAHASH_MODULO
+/**
+ * Recorrido por partes. Con la reduccion por modulo las casillas no conservan
+ * ningun orden al redimensionar, asi que el cursor es simplemente la casilla a
+ * visitar.
+ */
+unsigned tablahash_escanear(TablaHash tabla, unsigned cursor,
+                            FuncionVisitanteTabla visita, void *extra) {
+  if (cursor < tabla->capacidad)
+    tablahash_escanear_aux(tabla->elems, cursor, cursor, 0, ~0u, visita, extra);
+  if (tabla->elemsViejos != NULL && cursor < tabla->capacidadVieja)
+    tablahash_escanear_aux(tabla->elemsViejos, cursor, cursor, 0, ~0u, visita, extra);
+  unsigned fin = (tabla->capacidad > tabla->capacidadVieja) ? tabla->capacidad
+                                                            : tabla->capacidadVieja;
+  return (cursor + 1 < fin) ? cursor + 1 : 0;
+}
+#else
+/**
+ * Recorrido por partes. El cursor es un valor del hash mezclado: cada llamada
+ * visita los datos cuyo hash mezclado va desde el cursor hasta el final de su
+ * casilla en el arreglo actual. Como la casilla son los bits altos del hash
+ * mezclado, al redimensionar cada casilla se parte en varias consecutivas (o
+ * varias se juntan en una), y el cursor sigue separando los datos ya visitados
+ * de los que faltan.
+ */
+unsigned tablahash_escanear(TablaHash tabla, unsigned cursor,
+                            FuncionVisitanteTabla visita, void *extra) {
+  unsigned desplazamiento = 32 - __builtin_ctz(tabla->capacidad);
+  unsigned hasta = cursor | ((1u << desplazamiento) - 1);
+  tablahash_escanear_aux(tabla->elems, cursor >> desplazamiento,
+                         hasta >> desplazamiento, cursor, hasta, visita, extra);
+  if (tabla->elemsViejos != NULL) {
+    desplazamiento = 32 - __builtin_ctz(tabla->capacidadVieja);
+    tablahash_escanear_aux(tabla->elemsViejos, cursor >> desplazamiento,
+                           hasta >> desplazamiento, cursor, hasta, visita, extra);
+  }
+  return hasta + 1;
+}
+#endif
@@ -0,0 +1,244 @@
+#include "tablahashinline.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#define FACTOR_CARGA(numElms, casillas) ((float)(numElms)/(casillas))
+#define LIMITE 0.7
+#define INDICE(hash, capacidad) \
+  ((unsigned)((hash) * 2654435769u) >> (32 - __builtin_ctz(capacidad)))
+#define SIGUIENTE(idx, capacidad) (((idx) + 1) & ((capacidad) - 1))
+#define DISTANCIA(desde, hasta, capacidad) (((hasta) - (desde)) & ((capacidad) - 1))
+/**
+ * El hash 0 marca una casilla libre, asi que el hash de un dato se guarda
+ * como 1 si vale 0.
+ */
+#define LIBRE 0
+#define HASH_GUARDADO(hash) ((hash) != LIBRE ? (hash) : 1u)
+
+/**
+ * Estructura principal que representa la tabla.
+ * Los hashes y los datos estan en arreglos paralelos: hashes[i] es el hash
+ * del dato de la casilla i (o LIBRE), y ese dato ocupa los tamDato bytes de
+ * datos a partir de i * tamDato. El sondeo recorre el arreglo de hashes, que
+ * es denso, y solo compara los datos cuyos hashes coinciden.
+ */
+struct _TablaHashInline {
+  unsigned *hashes;
+  char *datos;
+  size_t tamDato;
+  size_t tamClave;
+  unsigned numElems;
+  unsigned capacidad;
+  FuncionComparadora comp;
+  FuncionHash hash;
+};
+
+/**
+ * Retorna la direccion del dato de la casilla idx.
+ */
+static char *tablahashinline_dato(TablaHashInline tabla, unsigned idx) {
+  return tabla->datos + (size_t)idx * tabla->tamDato;
+}
+
+/**
+ * Pide memoria para capacidad casillas libres.
+ */
+static void tablahashinline_casillas_crear(TablaHashInline tabla,
+                                           unsigned capacidad) {
+  tabla->hashes = calloc(capacidad, sizeof(unsigned));
+  assert(tabla->hashes != NULL);
+  tabla->datos = malloc(tabla->tamDato * capacidad);
+  assert(tabla->datos != NULL);
+  tabla->capacidad = capacidad;
+}
+
+/**
+ * Crea una nueva tabla vacia, con la capacidad dada.
+ */
+TablaHashInline tablahashinline_crear(unsigned capacidad, size_t tamDato,
+                                      size_t tamClave, FuncionComparadora comp,
+                                      FuncionHash hash) {
+  assert(tamDato > 0 && tamClave <= tamDato);
+  TablaHashInline tabla = malloc(sizeof(struct _TablaHashInline));
+  assert(tabla != NULL);
+  tabla->tamDato = tamDato;
+  tabla->tamClave = tamClave;
+  tabla->numElems = 0;
+  tabla->comp = comp;
+  tabla->hash = hash;
+
+  unsigned real = 2;
+  while (real < capacidad)
+    real *= 2;
+  tablahashinline_casillas_crear(tabla, real);
+  return tabla;
+}
+
+/**
+ * Destruye la tabla.
+ */
+void tablahashinline_destruir(TablaHashInline tabla) {
+  free(tabla->hashes);
+  free(tabla->datos);
+  free(tabla);
+}
+
+/**
+ * Retorna el numero de elementos de la tabla.
+ */
+int tablahashinline_nelems(TablaHashInline tabla) { return tabla->numElems; }
+
+/**
+ * Retorna la capacidad de la tabla.
+ */
+int tablahashinline_capacidad(TablaHashInline tabla) {
+  return tabla->capacidad;
+}
+
+/**
+ * Retorna 1 si la clave del dato de la casilla idx es igual a la del dato dado.
+ */
+static int tablahashinline_iguales(TablaHashInline tabla, unsigned idx,
+                                   const void *dato) {
+  char *guardado = tablahashinline_dato(tabla, idx);
+  if (tabla->comp != NULL)
+    return tabla->comp(guardado, (void *)dato) == 0;
+  return memcmp(guardado, dato, tabla->tamClave) == 0;
+}
+
+/**
+ * Retorna la casilla del dato, o la casilla libre en la que termino el sondeo
+ * si el dato no esta (en ese caso hashes[casilla] es LIBRE).
+ */
+static unsigned tablahashinline_sondear(TablaHashInline tabla, const void *dato,
+                                        unsigned hash) {
+  unsigned idx = INDICE(hash, tabla->capacidad);
+  while (tabla->hashes[idx] != LIBRE) {
+    if (tabla->hashes[idx] == hash && tablahashinline_iguales(tabla, idx, dato))
+      return idx;
+    idx = SIGUIENTE(idx, tabla->capacidad);
+  }
+  return idx;
+}
+
+/**
+ * Duplica la capacidad de la tabla y reubica todos los datos, sin volver a
+ * llamar a la funcion hash.
+ */
+static void tablahashinline_redimensionar(TablaHashInline tabla) {
+  unsigned *hashesAnteriores = tabla->hashes;
+  char *datosAnteriores = tabla->datos;
+  unsigned capacidadAnterior = tabla->capacidad;
+
+  tablahashinline_casillas_crear(tabla, capacidadAnterior * 2);
+  for (unsigned i = 0; i < capacidadAnterior; i++) {
+    if (hashesAnteriores[i] == LIBRE)
+      continue;
+    unsigned idx = INDICE(hashesAnteriores[i], tabla->capacidad);
+    while (tabla->hashes[idx] != LIBRE)
+      idx = SIGUIENTE(idx, tabla->capacidad);
+    tabla->hashes[idx] = hashesAnteriores[i];
+    memcpy(tablahashinline_dato(tabla, idx),
+           datosAnteriores + (size_t)i * tabla->tamDato, tabla->tamDato);
+  }
+  free(hashesAnteriores);
+  free(datosAnteriores);
+}
+
+/**
+ * Copia el dato en la tabla, o reemplaza el dato con la misma clave si ya se
+ * encontraba.
+ */
+void tablahashinline_insertar(TablaHashInline tabla, const void *dato) {
+  int insertado;
+  void *guardado = tablahashinline_buscar_o_insertar(tabla, dato, &insertado);
+  if (!insertado)
+    memcpy(guardado, dato, tabla->tamDato);
+}
+
+/**
+ * Retorna un puntero al dato de la tabla con la misma clave que el dato dado,
+ * copiandolo antes en la tabla si no se encontraba.
+ */
+void *tablahashinline_buscar_o_insertar_hash(TablaHashInline tabla,
+                                             const void *dato, unsigned hash,
+                                             int *insertado) {
+  if (FACTOR_CARGA(tabla->numElems + 1, tabla->capacidad) > LIMITE)
+    tablahashinline_redimensionar(tabla);
+
+  hash = HASH_GUARDADO(hash);
+  unsigned idx = tablahashinline_sondear(tabla, dato, hash);
+  int nuevo = (tabla->hashes[idx] == LIBRE);
+  if (nuevo) {
+    tabla->hashes[idx] = hash;
+    tabla->numElems++;
+    memcpy(tablahashinline_dato(tabla, idx), dato, tabla->tamDato);
+  }
+  if (insertado != NULL)
+    *insertado = nuevo;
+  return tablahashinline_dato(tabla, idx);
+}
+void *tablahashinline_buscar_o_insertar(TablaHashInline tabla, const void *dato,
+                                        int *insertado) {
+  return tablahashinline_buscar_o_insertar_hash(tabla, dato,
+                                                tabla->hash((void *)dato), insertado);
+}
+
+/**
+ * Retorna un puntero al dato de la tabla con la misma clave que el dato dado,
+ * o NULL si no se encuentra.
+ */
+void *tablahashinline_buscar_hash(TablaHashInline tabla, const void *dato,
+                                  unsigned hash) {
+  hash = HASH_GUARDADO(hash);
+  unsigned idx = tablahashinline_sondear(tabla, dato, hash);
+  return (tabla->hashes[idx] != LIBRE) ? tablahashinline_dato(tabla, idx) : NULL;
+}
+void *tablahashinline_buscar(TablaHashInline tabla, const void *dato) {
+  return tablahashinline_buscar_hash(tabla, dato, tabla->hash((void *)dato));
+}
+
+/**
+ * Adelanta la carga del hash y del dato de la casilla inicial.
+ */
+void tablahashinline_adelantar(TablaHashInline tabla, unsigned hash) {
+  unsigned idx = INDICE(HASH_GUARDADO(hash), tabla->capacidad);
+  __builtin_prefetch(&tabla->hashes[idx]);
+  __builtin_prefetch(tablahashinline_dato(tabla, idx));
+}
+
+/**
+ * Aplica visita a cada dato de la tabla.
+ */
+void tablahashinline_recorrer(TablaHashInline tabla,
+                              FuncionVisitanteTabla visita, void *extra) {
+  for (unsigned idx = 0; idx < tabla->capacidad; ++idx)
+    if (tabla->hashes[idx] != LIBRE)
+      visita(tablahashinline_dato(tabla, idx), extra);
+}
+
+/**
+ * Elimina el dato de la tabla con la misma clave que el dato dado. Los datos
+ * siguientes de la secuencia que pueden ocupar la casilla se corren hacia
+ * atras, asi que la tabla nunca acumula casillas eliminadas.
+ */
+void tablahashinline_eliminar(TablaHashInline tabla, const void *dato) {
+  unsigned hash = HASH_GUARDADO(tabla->hash((void *)dato));
+  unsigned hueco = tablahashinline_sondear(tabla, dato, hash);
+  if (tabla->hashes[hueco] == LIBRE)
+    return;
+  tabla->numElems--;
+
+  for (unsigned idx = SIGUIENTE(hueco, tabla->capacidad);
+       tabla->hashes[idx] != LIBRE; idx = SIGUIENTE(idx, tabla->capacidad)) {
+    unsigned inicial = INDICE(tabla->hashes[idx], tabla->capacidad);
+    if (DISTANCIA(inicial, idx, tabla->capacidad) >=
+        DISTANCIA(hueco, idx, tabla->capacidad)) {
+      tabla->hashes[hueco] = tabla->hashes[idx];
+      memcpy(tablahashinline_dato(tabla, hueco),
+             tablahashinline_dato(tabla, idx), tabla->tamDato);
+      hueco = idx;
+    }
+  }
+  tabla->hashes[hueco] = LIBRE;
+}
@@ -0,0 +1,96 @@
+#ifndef __TABLAHASHINLINE_H__
+#define __TABLAHASHINLINE_H__
+
+#include "tablahash.h"
+#include <stddef.h>
+
+/**
+ * Tabla hash que guarda los datos por valor, dentro de su propio arreglo.
+ * Todos los datos miden tamDato bytes, y de ellos los primeros tamClave bytes
+ * forman la clave (el resto puede ser un valor asociado). Insertar copia los
+ * bytes del dato con memcpy, asi que no hay funciones copiadora ni
+ * destructora ni una reserva de memoria por dato, y el sondeo no sigue
+ * punteros.
+ * Direccionamiento abierto con sondeo lineal, capacidad potencia de dos y
+ * eliminacion sin casillas eliminadas.
+ */
+typedef struct _TablaHashInline *TablaHashInline;
+
+/**
+ * Crea una nueva tabla vacia, con la capacidad dada (redondeada hacia arriba a
+ * una potencia de dos), para datos de tamDato bytes cuya clave son los
+ * primeros tamClave. La funcion hash recibe un puntero al dato y debe depender
+ * solo de la clave. Si comp es NULL, las claves se comparan con memcmp.
+ */
+TablaHashInline tablahashinline_crear(unsigned capacidad, size_t tamDato,
+                                      size_t tamClave, FuncionComparadora comp,
+                                      FuncionHash hash);
+
+/**
+ * Destruye la tabla.
+ */
+void tablahashinline_destruir(TablaHashInline tabla);
+
+/**
+ * Retorna el numero de elementos de la tabla.
+ */
+int tablahashinline_nelems(TablaHashInline tabla);
+
+/**
+ * Retorna la capacidad de la tabla.
+ */
+int tablahashinline_capacidad(TablaHashInline tabla);
+
+/**
+ * Copia el dato en la tabla, o reemplaza el dato con la misma clave si ya se
+ * encontraba.
+ */
+void tablahashinline_insertar(TablaHashInline tabla, const void *dato);
+
+/**
+ * Retorna un puntero al dato de la tabla con la misma clave que el dato dado,
+ * o NULL si no se encuentra. El puntero apunta dentro de la tabla: permite
+ * modificar el valor asociado (no la clave) y deja de ser valido en la
+ * siguiente insercion o eliminacion.
+ */
+void *tablahashinline_buscar(TablaHashInline tabla, const void *dato);
+
+/**
+ * Retorna un puntero al dato de la tabla con la misma clave que el dato dado;
+ * si no se encontraba, antes copia el dato en la tabla. Llama una sola vez a
+ * la funcion hash. Si insertado no es NULL, guarda en el 1 si el dato se
+ * inserto y 0 si ya estaba. El puntero es valido como el de
+ * tablahashinline_buscar.
+ */
+void *tablahashinline_buscar_o_insertar(TablaHashInline tabla, const void *dato,
+                                        int *insertado);
+
+/**
+ * Como tablahashinline_buscar_o_insertar y tablahashinline_buscar, pero con el
+ * hash del dato ya calculado (el que retornaria la funcion hash de la tabla),
+ * para quien lo necesita tambien para otra cosa.
+ */
+void *tablahashinline_buscar_o_insertar_hash(TablaHashInline tabla,
+                                             const void *dato, unsigned hash,
+                                             int *insertado);
+void *tablahashinline_buscar_hash(TablaHashInline tabla, const void *dato,
+                                  unsigned hash);
+
+/**
+ * Adelanta la carga de la casilla inicial de un dato con el hash dado.
+ */
+void tablahashinline_adelantar(TablaHashInline tabla, unsigned hash);
+
+/**
+ * Aplica visita a cada dato de la tabla (un puntero dentro de la tabla), en un
+ * orden no especificado. La funcion visitante no debe modificar la tabla.
+ */
+void tablahashinline_recorrer(TablaHashInline tabla,
+                              FuncionVisitanteTabla visita, void *extra);
+
+/**
+ * Elimina el dato de la tabla con la misma clave que el dato dado.
+ */
+void tablahashinline_eliminar(TablaHashInline tabla, const void *dato);
+
+#endif /* __TABLAHASHINLINE_H__ */
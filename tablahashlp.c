@@ -1,59 +1,164 @@
-#include "tablahash.h"
+#include "tablahashlp.h"
+#include "filtrobloom.h"
+#include "tablahashcontadores.h"
+#include "tablahashopciones.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #define FACTOR_CARGA(numElms, casillas) ((float)(numElms)/(casillas))
 #define LIMITE 0.7
+// Mayor carga maxima admitida: con sondeo lineal tiene que quedar una casilla libre.
+#define CARGA_TOPE 0.95
+#define TAM_LOTE 16
+// Casillas que recorre cada insercion o eliminacion al rearmar el filtro.
+#define PASOS_FILTRO 32
+/**
+ * Reduccion del hash a una posicion de la tabla. Por defecto la capacidad es
+ * siempre una potencia de dos y la posicion son los bits altos del hash
+ * multiplicado por 2^32 / phi (hashing de Fibonacci), asi que ni el calculo de
+ * la posicion ni el avance del sondeo usan una division. Compilando con
+ * TABLAHASH_MODULO se vuelve a la reduccion con %, para comparar.
+ */
+#ifdef TABLAHASH_MODULO
+#define INDICE(hash, capacidad) ((hash) % (capacidad))
+#define SIGUIENTE(idx, capacidad) (((idx) + 1) % (capacidad))
+#define DISTANCIA(desde, hasta, capacidad) \
+  (((hasta) + (capacidad) - (desde)) % (capacidad))
+#define MEZCLA(hash) (hash)
+#else
+#define INDICE(hash, capacidad) \
+  ((unsigned)((hash) * 2654435769u) >> (32 - __builtin_ctz(capacidad)))
+#define SIGUIENTE(idx, capacidad) (((idx) + 1) & ((capacidad) - 1))
+#define DISTANCIA(desde, hasta, capacidad) (((hasta) - (desde)) & ((capacidad) - 1))
+#define MEZCLA(hash) ((unsigned)((hash) * 2654435769u))
+#endif
 //IMPLEMENTACION DE TABLA HASH CON DIRECCIONAMIENTO ABIERTO (LINEAL PROOBING).//
 /**
  * Casillas en la que almacenaremos los datos de la tabla hash.
+ * Junto al dato se guarda el valor completo de la funcion hash, que ocupa el
+ * relleno que dejaba estado (la casilla sigue midiendo 16 bytes). Asi la
+ * redimension no vuelve a llamar a la funcion hash y el sondeo solo llama a la
+ * funcion comparadora cuando los hashes coinciden.
  */
 typedef struct {
   void *dato;
-  int estado; // 0 si casilla está libre, 1 si está ocupada, -1 si fue eliminada.
+  int estado; // 0 si casilla está libre, 1 si está ocupada.
+  unsigned hash;
 } CasillaHash;
 
 /**
  * Estructura principal que representa la tabla hash.
+ * Durante una redimension incremental, elemsViejos guarda el arreglo anterior
+ * (de capacidadVieja casillas), del cual ya se migraron las primeras
+ * migradas casillas. Fuera de una redimension, elemsViejos es NULL.
+ * filtro es NULL salvo que se active con tablahash_lp_filtro; eliminados
+ * cuenta los datos eliminados desde que se empezo a armar. Mientras se arma un
+ * filtro de reemplazo, filtroNuevo no es NULL y las busquedas siguen usando
+ * filtro, que sigue siendo valido para todos los datos. Si hay una migracion
+ * pendiente, filtroNuevo recibe cada dato migrado y reemplaza a filtro cuando
+ * la migracion termina; si no, recibe los datos de las primeras armadas
+ * casillas de elems y lo reemplaza cuando las recorre todas.
  */
 struct _TablaHash {
   CasillaHash *elems;
   unsigned numElems;
   unsigned capacidad;
+  CasillaHash *elemsViejos;
+  unsigned capacidadVieja;
+  unsigned migradas;
+  unsigned pasos;
   FuncionCopiadora copia;
   FuncionComparadora comp;
   FuncionDestructora destr;
   FuncionHash hash;
+  TablaHashOpciones opciones;
+  FiltroBloom filtro;
+  FiltroBloom filtroNuevo;
+  unsigned armadas;
+  unsigned bitsFiltro;
+  unsigned eliminados;
+  unsigned long rechazos;
+  unsigned long falsosPositivos;
+  CONTADORES_CAMPO
 };
 
 /**
- * Crea una nueva tabla hash vacia, con la capacidad dada.
+ * Pide memoria para un arreglo de casillas libres. Se pide en cero para no
+ * recorrer el arreglo al crearlo: en los arreglos grandes el sistema entrega
+ * las paginas en cero a medida que se usan, y asi la redimension incremental
+ * no paga de una vez el costo de inicializar todo el arreglo nuevo.
  */
-TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
-                          FuncionComparadora comp, FuncionDestructora destr,
-                          FuncionHash hash)
+static CasillaHash *tablahash_casillas_crear(unsigned capacidad) {
+  CasillaHash *elems = calloc(capacidad, sizeof(CasillaHash));
+  assert(elems);
+  return elems;
+}
+
+/**
+ * Retorna la capacidad con la que se crea realmente la tabla: sin
+ * TABLAHASH_MODULO, la menor potencia de dos (al menos 2) mayor o igual a la
+ * pedida.
+ */
+static unsigned tablahash_capacidad_real(unsigned capacidad) {
+#ifdef TABLAHASH_MODULO
+  return capacidad;
+#else
+  unsigned real = 2;
+  while (real < capacidad)
+    real *= 2;
+  return real;
+#endif
+}
+
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad y las opciones dadas.
+ */
+TablaHash tablahash_crear_con_opciones(unsigned capacidad, FuncionCopiadora copia,
+                                       FuncionComparadora comp,
+                                       FuncionDestructora destr, FuncionHash hash,
+                                       const TablaHashOpciones *opciones)
 {
   // Pedimos memoria para la estructura principal y las casillas.
   TablaHash tabla = malloc(sizeof(struct _TablaHash));
   assert(tabla);
-  tabla->elems = malloc(sizeof(CasillaHash)*capacidad);
-  assert(tabla->elems);
+  tabla->opciones = tablahash_opciones_completar(opciones, LIMITE, CARGA_TOPE);
+  if (capacidad < tabla->opciones.capacidadMinima)
+    capacidad = tabla->opciones.capacidadMinima;
+  // Inicializamos las casillas con datos nulos.
+  capacidad = tablahash_capacidad_real(capacidad);
+  tabla->elems = tablahash_casillas_crear(capacidad);
   tabla->capacidad = capacidad;
+  tabla->elemsViejos = NULL;
+  tabla->capacidadVieja = 0;
+  tabla->migradas = 0;
+  tabla->pasos = 0;
   tabla->copia = copia;
   tabla->comp = comp;
   tabla->destr = destr;
   tabla->hash = hash;
   tabla->numElems = 0;
+  tabla->filtro = NULL;
+  tabla->filtroNuevo = NULL;
+  tabla->armadas = 0;
+  tabla->bitsFiltro = 0;
+  tabla->eliminados = 0;
+  tabla->rechazos = 0;
+  tabla->falsosPositivos = 0;
+  CONTADORES_INICIAR(tabla);
 
-  // Inicializamos las casillas con datos nulos.
-  for (unsigned idx = 0; idx < tabla->capacidad; ++idx)
-  {
-    tabla->elems[idx].dato = NULL;
-    tabla->elems[idx].estado = 0;
-  }
-  
   return tabla;
 }
 
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad dada.
+ */
+TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
+                          FuncionComparadora comp, FuncionDestructora destr,
+                          FuncionHash hash)
+{
+  return tablahash_crear_con_opciones(capacidad, copia, comp, destr, hash, NULL);
+}
+
 /**
  * Retorna el numero de elementos de la tabla.
  */
@@ -67,142 +172,595 @@ int tablahash_capacidad(TablaHash tabla){return tabla->capacidad;}
 /**
  * Destruye la tabla.
  */
-void tablahash_destruir(TablaHash tabla){
-  for (int idx = 0; idx < tabla->capacidad; ++idx)
+static void tablahash_casillas_destruir(CasillaHash *elems, unsigned capacidad,
+                                        FuncionDestructora destr) {
+  for (unsigned idx = 0; idx < capacidad; ++idx)
   {
-    if (tabla->elems[idx].dato != NULL)
-      tabla->destr(tabla->elems[idx].dato);
+    if (elems[idx].dato != NULL)
+      destr(elems[idx].dato);
   }
-  free(tabla->elems);
+  free(elems);
+}
+void tablahash_destruir(TablaHash tabla){
+  tablahash_casillas_destruir(tabla->elems, tabla->capacidad, tabla->destr);
+  if (tabla->elemsViejos != NULL)
+    tablahash_casillas_destruir(tabla->elemsViejos, tabla->capacidadVieja, tabla->destr);
+  if (tabla->filtro != NULL)
+    filtrobloom_destruir(tabla->filtro);
+  if (tabla->filtroNuevo != NULL)
+    filtrobloom_destruir(tabla->filtroNuevo);
   free(tabla);
 }
 
 /**
- * Inserta un dato en la tabla, o lo reemplaza si ya se encontraba.
+ * Empieza a armar un filtro de reemplazo vacio, dimensionado para la
+ * capacidad actual, descartando el que se estaba armando.
  */
-static void tablahash_insertar_aux(TablaHash tabla, void* dato, unsigned idx,
-                                                                    int indice_borrado)
-{
-  CasillaHash* casilla = &tabla->elems[idx];
-  // Caso en que la casilla esté vacia.
-  if (casilla->estado == 0)
-  {
-    unsigned idx_to_put = (indice_borrado != -1) ? indice_borrado : idx; //verifico si encontre una posicion eliminada.
-    tabla->elems[idx_to_put].dato = tabla->copia(dato);
-    tabla->elems[idx_to_put].estado = 1;
-    tabla->numElems++;
+static void tablahash_filtro_empezar(TablaHash tabla) {
+  if (tabla->filtroNuevo != NULL)
+    filtrobloom_destruir(tabla->filtroNuevo);
+  tabla->filtroNuevo = filtrobloom_crear(
+      tabla->capacidad * tabla->opciones.cargaMaxima, tabla->bitsFiltro);
+  tabla->armadas = 0;
+  tabla->eliminados = 0;
+}
+
+/**
+ * Reemplaza el filtro por el que se termino de armar.
+ */
+static void tablahash_filtro_reemplazar(TablaHash tabla) {
+  if (tabla->filtro != NULL)
+    filtrobloom_destruir(tabla->filtro);
+  tabla->filtro = tabla->filtroNuevo;
+  tabla->filtroNuevo = NULL;
+}
+
+/**
+ * Fuera de una migracion, agrega al filtro de reemplazo los datos de las
+ * siguientes n casillas de elems, y lo pone en uso al llegar al final. Los
+ * datos que se insertan mientras tanto se agregan a los dos filtros, y los que
+ * la eliminacion corre hacia atras se vuelven a agregar (ver
+ * tablahash_correr_hacia_atras), asi que ninguno queda afuera.
+ */
+static void tablahash_filtro_avanzar(TablaHash tabla, unsigned n) {
+  if (tabla->filtroNuevo == NULL || tabla->elemsViejos != NULL)
+    return;
+  for (; n > 0 && tabla->armadas < tabla->capacidad; n--, tabla->armadas++)
+    if (tabla->elems[tabla->armadas].estado == 1)
+      filtrobloom_agregar(tabla->filtroNuevo,
+                          tabla->elems[tabla->armadas].hash);
+  if (tabla->armadas == tabla->capacidad)
+    tablahash_filtro_reemplazar(tabla);
+}
+
+/**
+ * Arma el filtro de una vez, con los hashes de los datos de ambos arreglos.
+ */
+static void tablahash_filtro_armar(TablaHash tabla) {
+  tablahash_filtro_empezar(tabla);
+  for (unsigned idx = 0; idx < tabla->capacidad; ++idx)
+    if (tabla->elems[idx].estado == 1)
+      filtrobloom_agregar(tabla->filtroNuevo, tabla->elems[idx].hash);
+  if (tabla->elemsViejos != NULL)
+    for (unsigned idx = tabla->migradas; idx < tabla->capacidadVieja; ++idx)
+      if (tabla->elemsViejos[idx].estado == 1)
+        filtrobloom_agregar(tabla->filtroNuevo, tabla->elemsViejos[idx].hash);
+  tablahash_filtro_reemplazar(tabla);
+}
+
+/**
+ * Activa, o desactiva con bitsPorDato == 0, el filtro de las busquedas.
+ */
+void tablahash_lp_filtro(TablaHash tabla, unsigned bitsPorDato) {
+  tabla->bitsFiltro = bitsPorDato;
+  tabla->rechazos = 0;
+  tabla->falsosPositivos = 0;
+  if (bitsPorDato != 0)
+    tablahash_filtro_armar(tabla);
+  else if (tabla->filtro != NULL)
+  {
+    filtrobloom_destruir(tabla->filtro);
+    tabla->filtro = NULL;
+    if (tabla->filtroNuevo != NULL)
+      filtrobloom_destruir(tabla->filtroNuevo);
+    tabla->filtroNuevo = NULL;
+  }
+}
+
+/**
+ * Retorna la fraccion de busquedas de datos ausentes que el filtro dejo pasar.
+ */
+double tablahash_lp_falsos_positivos(TablaHash tabla) {
+  unsigned long ausentes = tabla->rechazos + tabla->falsosPositivos;
+  return ausentes ? (double)tabla->falsosPositivos / ausentes : 0;
+}
+
+/**
+ * Vacia la casilla hueco, corriendo hacia atras los datos siguientes de la
+ * secuencia que pueden ocuparla (los que tienen su casilla inicial en el hueco
+ * o antes). Asi ninguna busqueda se corta antes de llegar a su dato y la tabla
+ * nunca acumula casillas eliminadas. Si filtro no es NULL, se le agregan los
+ * datos corridos: un dato puede pasar de una casilla que el filtro de
+ * reemplazo todavia no recorrio a una que ya recorrio.
+ */
+static void tablahash_correr_hacia_atras(CasillaHash *elems, unsigned capacidad,
+                                         unsigned hueco, FiltroBloom filtro){
+  // Aun con la tabla llena, cada casilla se mira a lo sumo una vez.
+  unsigned idx = SIGUIENTE(hueco, capacidad);
+  for (unsigned i = 1; i < capacidad && elems[idx].estado == 1;
+       ++i, idx = SIGUIENTE(idx, capacidad))
+  {
+    unsigned inicial = INDICE(elems[idx].hash, capacidad);
+    if (DISTANCIA(inicial, idx, capacidad) >= DISTANCIA(hueco, idx, capacidad))
+    {
+      elems[hueco] = elems[idx];
+      hueco = idx;
+      if (filtro != NULL)
+        filtrobloom_agregar(filtro, elems[idx].hash);
+    }
+  }
+  elems[hueco].dato = NULL;
+  elems[hueco].estado = 0;
+}
+
+/**
+ * Migra a lo sumo n casillas del arreglo anterior al nuevo, sin copiar los
+ * datos. Cada dato migrado se quita del arreglo anterior corriendo hacia atras
+ * los siguientes, asi que la casilla se vuelve a mirar hasta que quede libre.
+ * Las casillas ya migradas quedan siempre libres, y ningun dato que falte
+ * migrar tiene su casilla inicial entre ellas. Cada dato migrado se agrega
+ * al filtro de reemplazo, si lo hay. Cuando termina de migrar, libera el
+ * arreglo anterior y pone en uso el filtro de reemplazo.
+ */
+static void tablahash_migrar(TablaHash tabla, unsigned n) {
+  if (tabla->elemsViejos == NULL)
     return;
+  RELOJ_INICIAR(inicio);
+  for (; n > 0 && tabla->migradas < tabla->capacidadVieja; n--, tabla->migradas++)
+  {
+    CasillaHash *vieja = &tabla->elemsViejos[tabla->migradas];
+    while (vieja->estado == 1)
+    {
+      // El dato no puede estar repetido en el arreglo nuevo: al insertarlo alli
+      // se lo elimina del anterior.
+      unsigned idx = INDICE(vieja->hash, tabla->capacidad);
+      while (tabla->elems[idx].estado == 1)
+        idx = SIGUIENTE(idx, tabla->capacidad);
+      tabla->elems[idx] = *vieja;
+      if (tabla->filtroNuevo != NULL)
+        filtrobloom_agregar(tabla->filtroNuevo, vieja->hash);
+      tablahash_correr_hacia_atras(tabla->elemsViejos, tabla->capacidadVieja,
+                                   tabla->migradas, NULL);
+    }
   }
-  //Caso en que la casilla ya esté ocupada por un dato repetido.
-  if (casilla->estado == 1 && tabla->comp(casilla->dato,dato) == 0)
+  if (tabla->migradas == tabla->capacidadVieja)
   {
-    tabla->destr(casilla->dato);
-    casilla->dato = tabla->copia(dato);
+    free(tabla->elemsViejos);
+    tabla->elemsViejos = NULL;
+    tabla->capacidadVieja = 0;
+    tabla->migradas = 0;
+    if (tabla->filtroNuevo != NULL)
+      tablahash_filtro_reemplazar(tabla);
+  }
+  RELOJ_DETENER(tabla, inicio);
+}
+
+/**
+ * Reemplaza el arreglo de casillas por uno de la capacidad dada y deja el
+ * anterior pendiente de migrar. El filtro no se rearma aca: el actual sigue
+ * sirviendo hasta que la migracion llena el de la nueva capacidad.
+ */
+static void tablahash_iniciar_migracion(TablaHash tabla, unsigned capacidad) {
+  assert(tabla->elemsViejos == NULL);
+  RELOJ_INICIAR(inicio);
+  REGISTRAR_REDIMENSION(tabla);
+  tabla->elemsViejos = tabla->elems;
+  tabla->capacidadVieja = tabla->capacidad;
+  tabla->migradas = 0;
+  tabla->capacidad = capacidad;
+  tabla->elems = tablahash_casillas_crear(tabla->capacidad);
+  if (tabla->filtro != NULL)
+    tablahash_filtro_empezar(tabla);
+  RELOJ_DETENER(tabla, inicio);
+}
+
+/**
+ * Cambia la capacidad de la tabla (redondeada a una potencia de dos), despues
+ * de completar la migracion pendiente si la hay. Con la redimension
+ * incremental activa, la migracion al nuevo arreglo queda pendiente.
+ */
+static void tablahash_redimensionar_a(TablaHash tabla, unsigned capacidad) {
+  tablahash_migrar(tabla, tabla->capacidadVieja);
+  tablahash_iniciar_migracion(tabla, tablahash_capacidad_real(capacidad));
+  if (tabla->pasos == 0)
+    tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Agranda la tabla de una vez para que entren n datos sin redimensionar.
+ */
+void tablahash_reservar(TablaHash tabla, unsigned n) {
+  unsigned capacidad = tablahash_capacidad_para(&tabla->opciones, n);
+  if (tablahash_capacidad_real(capacidad) <= tabla->capacidad)
     return;
+  tablahash_redimensionar_a(tabla, capacidad);
+  tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Activa la redimension incremental, migrando a lo sumo pasos casillas por
+ * operacion.
+ */
+void tablahash_redimension_incremental(TablaHash tabla, unsigned pasos) {
+  tabla->pasos = pasos;
+  if (pasos == 0)
+    tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Retorna la posicion del dato en el arreglo de casillas, o -1 si no esta.
+ * El sondeo termina en la primera casilla libre. Si sondeos no es NULL, le
+ * suma las casillas visitadas.
+ */
+static int tablahash_buscar_indice(CasillaHash *elems, unsigned capacidad,
+                                   FuncionComparadora comp, void *dato,
+                                   unsigned hash, unsigned *sondeos) {
+  unsigned idx = INDICE(hash, capacidad);
+  for (unsigned i = 0; i < capacidad; ++i)
+  {
+    CONTAR(sondeos, 1);
+    if (elems[idx].estado == 0)
+      return -1;
+    if (elems[idx].hash == hash && comp(elems[idx].dato, dato) == 0)
+      return idx;
+    idx = SIGUIENTE(idx, capacidad);
   }
-  //Caso en que la casilla haya sido eliminada y sea la primera encontrada.
-  if (casilla->estado == -1 && indice_borrado == -1)
-    indice_borrado = idx;
-  
-  unsigned nuevo_idx = (idx + 1) % tabla->capacidad;
-  tablahash_insertar_aux(tabla, dato, nuevo_idx,indice_borrado);
+  return -1;
 }
-void tablahash_insertar(TablaHash tabla, void *dato){
-  if (FACTOR_CARGA(tabla->numElems,tabla->capacidad) > LIMITE)
-    tablahash_redimensionar(tabla);
 
-  unsigned idx = tabla->hash(dato) % tabla->capacidad;
-  
-  tablahash_insertar_aux(tabla, dato, idx, -1);
+/**
+ * Elimina el dato de la tabla que coincida con el dato dado.
+ */
+static int tablahash_eliminar_aux(TablaHash tabla, CasillaHash *elems,
+                                  unsigned capacidad, void *dato, unsigned hash){
+  int indice = tablahash_buscar_indice(elems, capacidad, tabla->comp, dato, hash,
+                                       NULL);
+  //Caso en que el dato no se encuentra.
+  if (indice == -1)
+    return 0;
+  //Caso en que encuentra al dato a eliminar.
+  tabla->destr(elems[indice].dato);
+  // Fuera de una migracion, el filtro de reemplazo se arma recorriendo elems.
+  tablahash_correr_hacia_atras(elems, capacidad, indice,
+                               (tabla->elemsViejos == NULL) ? tabla->filtroNuevo
+                                                            : NULL);
+  tabla->numElems--;
+  // El filtro no puede quitar el dato: cuando acumula demasiados datos
+  // eliminados se empieza a armar otro, de a PASOS_FILTRO casillas.
+  if (tabla->filtro != NULL &&
+      ++tabla->eliminados > tabla->capacidad * tabla->opciones.cargaMaxima / 2 &&
+      tabla->filtroNuevo == NULL)
+    tablahash_filtro_empezar(tabla);
+  return 1;
+}
+void tablahash_eliminar_hash(TablaHash tabla, void *dato, unsigned hash){
+  tablahash_migrar(tabla, tabla->pasos);
+  tablahash_filtro_avanzar(tabla, PASOS_FILTRO);
+  if (!tablahash_eliminar_aux(tabla, tabla->elems, tabla->capacidad, dato, hash)
+      && (tabla->elemsViejos == NULL ||
+          !tablahash_eliminar_aux(tabla, tabla->elemsViejos, tabla->capacidadVieja,
+                                  dato, hash)))
+    return;
+  // Si quedo por debajo de la carga minima, achicamos la tabla.
+  unsigned capacidad = tablahash_capacidad_real(tablahash_capacidad_achicada(
+      &tabla->opciones, tabla->numElems, tabla->capacidad));
+  if (capacidad < tabla->capacidad)
+    tablahash_redimensionar_a(tabla, capacidad);
+}
+void tablahash_eliminar(TablaHash tabla, void *dato){
+  tablahash_eliminar_hash(tabla, dato, tabla->hash(dato));
+}
+
+/**
+ * Inserta un dato en la tabla, o lo reemplaza si ya se encontraba.
+ */
+static void tablahash_insertar_aux(TablaHash tabla, void* dato, unsigned hash)
+{
+  unsigned idx = INDICE(hash, tabla->capacidad);
+  for (; tabla->elems[idx].estado == 1; idx = SIGUIENTE(idx, tabla->capacidad))
+  {
+    CasillaHash* casilla = &tabla->elems[idx];
+    //Caso en que la casilla ya esté ocupada por un dato repetido.
+    if (casilla->hash == hash && tabla->comp(casilla->dato, dato) == 0)
+    {
+      tabla->destr(casilla->dato);
+      casilla->dato = tabla->copia(dato);
+      return;
+    }
+  }
+  // Caso en que llegamos a una casilla vacia: el dato no estaba.
+  tabla->elems[idx].dato = tabla->copia(dato);
+  tabla->elems[idx].hash = hash;
+  tabla->elems[idx].estado = 1;
+  tabla->numElems++;
+}
+void tablahash_insertar_hash(TablaHash tabla, void *dato, unsigned hash){
+  tablahash_migrar(tabla, tabla->pasos);
+  tablahash_filtro_avanzar(tabla, PASOS_FILTRO);
+  // Se cuenta el dato nuevo, para que siempre quede al menos una casilla libre.
+  if (FACTOR_CARGA(tabla->numElems + 1,tabla->capacidad) > tabla->opciones.cargaMaxima)
+    tablahash_redimensionar_a(tabla, tablahash_capacidad_crecida(&tabla->opciones,
+                                                                 tabla->capacidad));
+
+  // Si el dato todavia esta en el arreglo anterior, lo reemplazamos en el nuevo.
+  if (tabla->elemsViejos != NULL)
+    tablahash_eliminar_aux(tabla, tabla->elemsViejos, tabla->capacidadVieja, dato, hash);
+
+  tablahash_insertar_aux(tabla, dato, hash);
+  if (tabla->filtro != NULL)
+    filtrobloom_agregar(tabla->filtro, hash);
+  if (tabla->filtroNuevo != NULL)
+    filtrobloom_agregar(tabla->filtroNuevo, hash);
+}
+void tablahash_insertar(TablaHash tabla, void *dato){
+  tablahash_insertar_hash(tabla, dato, tabla->hash(dato));
 }
 
 /**
  * Retorna el dato de la tabla que coincida con el dato dado, o NULL si el dato
  * buscado no se encuentra en la tabla.
  */
-static void* tablahash_buscar_aux(TablaHash tabla, void* dato, unsigned indice, unsigned indice_incio){
-  //Caso en que la casilla esta vacia, el dato no se encuentra.
-  if (tabla->elems[indice].estado == 0)
-    return NULL;
-  //Caso en que haya encontrado el dato
-  if (tabla->elems[indice].estado == 1 && tabla->comp(tabla->elems[indice].dato,dato) == 0)
-    return tabla->elems[indice].dato;
-  
-  indice = (indice + 1) % tabla->capacidad;
-  if (indice == indice_incio)//Verifico que no este en el mismo indice donde comence.
+void *tablahash_buscar_hash(TablaHash tabla, void *dato, unsigned hash){
+  tablahash_migrar(tabla, tabla->pasos);
+  if (tabla->filtro != NULL && !filtrobloom_puede_contener(tabla->filtro, hash))
+  {
+    tabla->rechazos++;
+    REGISTRAR_BUSQUEDA(tabla, 0, 0);
     return NULL;
-  
-  return tablahash_buscar_aux(tabla,dato,indice,indice_incio);    
+  }
+  unsigned sondeos = 0;
+  int idx = tablahash_buscar_indice(tabla->elems, tabla->capacidad, tabla->comp,
+                                    dato, hash, &sondeos);
+  void *encontrado = (idx != -1) ? tabla->elems[idx].dato : NULL;
+  // Mientras dure la migracion, el dato puede seguir en el arreglo anterior.
+  if (idx == -1 && tabla->elemsViejos != NULL)
+  {
+    idx = tablahash_buscar_indice(tabla->elemsViejos, tabla->capacidadVieja,
+                                  tabla->comp, dato, hash, &sondeos);
+    if (idx != -1)
+      encontrado = tabla->elemsViejos[idx].dato;
+  }
+  REGISTRAR_BUSQUEDA(tabla, sondeos, idx != -1);
+  if (tabla->filtro != NULL && idx == -1)
+    tabla->falsosPositivos++;
+  return encontrado;
 }
 void *tablahash_buscar(TablaHash tabla, void *dato){
-  unsigned idx = tabla->hash(dato) % tabla->capacidad;
+  return tablahash_buscar_hash(tabla, dato, tabla->hash(dato));
+}
 
-  return tablahash_buscar_aux(tabla, dato, idx, idx);
+/**
+ * Calcula los hashes de un lote de a lo sumo TAM_LOTE datos y adelanta la
+ * carga de la casilla inicial de cada uno.
+ */
+static void tablahash_preparar_lote(TablaHash tabla, void **datos, size_t n,
+                                    unsigned *hashes){
+  for (size_t i = 0; i < n; i++)
+  {
+    hashes[i] = tabla->hash(datos[i]);
+    __builtin_prefetch(&tabla->elems[INDICE(hashes[i], tabla->capacidad)]);
+    if (tabla->filtro != NULL)
+      filtrobloom_adelantar(tabla->filtro, hashes[i]);
+  }
 }
 
 /**
- * Elimina el dato de la tabla que coincida con el dato dado.
+ * Busca n datos de una vez, de a lotes de TAM_LOTE.
  */
-static void tablahash_eliminar_aux(TablaHash tabla, void* dato, unsigned indice, unsigned indice_incio){
-  //Caso en que la casilla estaba vacia.
-  if (tabla->elems[indice].estado == 0)
-    return;
-  //Caso en que encuentra al dato a eliminar.
-  if (tabla->elems[indice].estado == 1 && tabla->comp(tabla->elems[indice].dato,dato) == 0){
-    tabla->destr(tabla->elems[indice].dato);
-    tabla->elems[indice].dato = NULL;
-    tabla->elems[indice].estado = -1;
-    tabla->numElems--;
-    return;
+void tablahash_buscar_lote(TablaHash tabla, void **claves, size_t n,
+                           void **resultados){
+  unsigned hashes[TAM_LOTE];
+  for (size_t inicio = 0; inicio < n; inicio += TAM_LOTE)
+  {
+    size_t lote = (n - inicio < TAM_LOTE) ? n - inicio : TAM_LOTE;
+    tablahash_preparar_lote(tabla, &claves[inicio], lote, hashes);
+    for (size_t i = 0; i < lote; i++)
+      resultados[inicio + i] = tablahash_buscar_hash(tabla, claves[inicio + i], hashes[i]);
   }
-  indice = (indice + 1) % tabla->capacidad;
-  if (indice == indice_incio)//Verifico no volver a empezar.
-    return;
-  
-  tablahash_eliminar_aux(tabla,dato,indice,indice_incio); 
 }
-void tablahash_eliminar(TablaHash tabla, void *dato){
-  unsigned indice = tabla->hash(dato) % tabla->capacidad;
-  tablahash_eliminar_aux(tabla,dato,indice,indice);
+
+/**
+ * Inserta n datos de una vez, de a lotes de TAM_LOTE.
+ */
+void tablahash_insertar_lote(TablaHash tabla, void **datos, size_t n){
+  unsigned hashes[TAM_LOTE];
+  for (size_t inicio = 0; inicio < n; inicio += TAM_LOTE)
+  {
+    size_t lote = (n - inicio < TAM_LOTE) ? n - inicio : TAM_LOTE;
+    tablahash_preparar_lote(tabla, &datos[inicio], lote, hashes);
+    for (size_t i = 0; i < lote; i++)
+      tablahash_insertar_hash(tabla, datos[inicio + i], hashes[i]);
+  }
 }
 
 /**
- * Duplica la capacidad de la tabla y reposiciona todos los elementos de acuerdo a la nueva
- * posicion que le asigne la funcion de hash.
+ * Multiplica la capacidad de la tabla por el factor de crecimiento y reposiciona todos los
+ * elementos de acuerdo a la nueva posicion que le asigne la funcion de hash.
  */
 void tablahash_redimensionar(TablaHash tabla){
-  //Guardo la informacion de la tabla.
-  CasillaHash* elmsAnteriores = tabla->elems;
-  unsigned capacidadAnterior = tabla->capacidad;
-  unsigned numelmsAnteriores = tabla->numElems;
-  //inicializo las nuevas casillas de la tabla redimensionada.
-  tabla->capacidad*=2;
-  CasillaHash* nuevaTabla = malloc(sizeof(CasillaHash) * tabla->capacidad);
-  assert(nuevaTabla);
-  for (unsigned i = 0; i < tabla->capacidad; i++)
-  {
-    nuevaTabla[i].dato = NULL;
-    nuevaTabla[i].estado = 0;
+  //Reubico todos los elementos en un arreglo de mayor capacidad.
+  tablahash_redimensionar_a(tabla, tablahash_capacidad_crecida(&tabla->opciones,
+                                                               tabla->capacidad));
+  tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Recorre un arreglo de casillas acumulando sus estadisticas estructurales.
+ * Un dato esta desbordado si no quedo en su casilla inicial.
+ */
+static void tablahash_estadisticas_aux(CasillaHash *elems, unsigned capacidad,
+                                       unsigned desde,
+                                       TablaHashEstadisticas *estadisticas){
+  for (unsigned i = desde; i < capacidad; ++i)
+  {
+    if (elems[i].estado != 1)
+      continue;
+    estadisticas->casillasUsadas++;
+    unsigned distancia = DISTANCIA(INDICE(elems[i].hash, capacidad), i, capacidad);
+    if (distancia != 0)
+      estadisticas->desbordados++;
+    if (distancia + 1 > estadisticas->sondeoMaximo)
+      estadisticas->sondeoMaximo = distancia + 1;
   }
-  tabla->numElems = 0;
-  //Reubico los elementos anteriores en la nueva tabla.
-  for (unsigned i = 0; i < capacidadAnterior; i++)
+}
+
+/**
+ * Completa estadisticas con el estado actual de la tabla y, si esta
+ * instrumentada, con los contadores acumulados desde su creacion.
+ */
+void tablahash_estadisticas(TablaHash tabla, TablaHashEstadisticas *estadisticas){
+  memset(estadisticas, 0, sizeof(TablaHashEstadisticas));
+  estadisticas->numElems = tabla->numElems;
+  estadisticas->capacidad = tabla->capacidad;
+  tablahash_estadisticas_aux(tabla->elems, tabla->capacidad, 0, estadisticas);
+  if (tabla->elemsViejos != NULL)
+    tablahash_estadisticas_aux(tabla->elemsViejos, tabla->capacidadVieja,
+                               tabla->migradas, estadisticas);
+  contadores_volcar(tabla, estadisticas);
+}
+
+/**
+ * Aplica visita a cada dato de la tabla, incluidos los que todavia no se
+ * migraron del arreglo anterior.
+ */
+void tablahash_recorrer(TablaHash tabla, FuncionVisitanteTabla visita,
+                        void *extra){
+  for (unsigned idx = 0; idx < tabla->capacidad; ++idx)
+    if (tabla->elems[idx].estado == 1)
+      visita(tabla->elems[idx].dato, extra);
+  if (tabla->elemsViejos != NULL)
+    for (unsigned idx = tabla->migradas; idx < tabla->capacidadVieja; ++idx)
+      if (tabla->elemsViejos[idx].estado == 1)
+        visita(tabla->elemsViejos[idx].dato, extra);
+}
+
+/**
+ * Estructura del iterador: recorre las casillas de elems y, al terminarlas,
+ * las del arreglo anterior que quedan por migrar.
+ */
+struct _TablaHashIter {
+  TablaHash tabla;
+  CasillaHash *elems;
+  unsigned capacidad;
+  unsigned idx;
+};
+
+/**
+ * Crea un iterador sobre los datos de la tabla.
+ */
+TablaHashIter tablahash_iter_crear(TablaHash tabla){
+  TablaHashIter iter = malloc(sizeof(struct _TablaHashIter));
+  assert(iter);
+  iter->tabla = tabla;
+  iter->elems = tabla->elems;
+  iter->capacidad = tabla->capacidad;
+  iter->idx = 0;
+  return iter;
+}
+
+/**
+ * Retorna el siguiente dato del iterador, o NULL si ya se recorrieron todos.
+ */
+void *tablahash_iter_siguiente(TablaHashIter iter){
+  for (;;)
+  {
+    for (; iter->idx < iter->capacidad; ++iter->idx)
+      if (iter->elems[iter->idx].estado == 1)
+        return iter->elems[iter->idx++].dato;
+    // Terminado el arreglo actual, seguimos con el anterior, si lo hay.
+    TablaHash tabla = iter->tabla;
+    if (iter->elems != tabla->elems || tabla->elemsViejos == NULL)
+      return NULL;
+    iter->elems = tabla->elemsViejos;
+    iter->capacidad = tabla->capacidadVieja;
+    iter->idx = tabla->migradas;
+  }
+}
+
+/**
+ * Destruye el iterador.
+ */
+void tablahash_iter_destruir(TablaHashIter iter){
+  free(iter);
+}
+
+/**
+ * Aplica visita a los datos de elems cuya casilla inicial esta entre primera y
+ * ultima y cuyo hash mezclado esta entre desde y hasta. Los datos de una
+ * casilla inicial ocupan casillas consecutivas a partir de ella, asi que basta
+ * con recorrer cada secuencia hasta la primera casilla libre.
+ */
+static void tablahash_escanear_aux(CasillaHash *elems, unsigned capacidad,
+                                   unsigned primera, unsigned ultima,
+                                   unsigned desde, unsigned hasta,
+                                   FuncionVisitanteTabla visita, void *extra){
+  for (unsigned inicial = primera; ; ++inicial)
   {
-    if (elmsAnteriores[i].dato != NULL)
+    unsigned idx = inicial;
+    for (unsigned i = 0; i < capacidad && elems[idx].estado == 1;
+         ++i, idx = SIGUIENTE(idx, capacidad))
     {
-      void* dato = elmsAnteriores[i].dato;
-      unsigned h = tabla->hash(dato) % tabla->capacidad;
-      unsigned idx = h;
-      unsigned j = 0;
-      while (nuevaTabla[idx].estado == 1) {
-        j++;
-        idx = (h + j) % tabla->capacidad;
-      }
-    nuevaTabla[idx].dato = dato; // No se copia, ya existe
-    nuevaTabla[idx].estado = 1;
-    tabla->numElems++;
-  }
-  }
-  free(elmsAnteriores);
-  tabla->elems = nuevaTabla;
-}
\ No newline at end of file
+      unsigned hash = elems[idx].hash;
+      if (INDICE(hash, capacidad) == inicial && MEZCLA(hash) >= desde &&
+          MEZCLA(hash) <= hasta)
+        visita(elems[idx].dato, extra);
+    }
+    if (inicial == ultima)
+      return;
+  }
+}
+
+#ifdef TABLAHASH_MODULO
+/**
+ * Recorrido por partes. Con la reduccion por modulo las casillas no conservan
+ * ningun orden al redimensionar, asi que el cursor es simplemente la casilla
+ * inicial a visitar.
+ */
+unsigned tablahash_escanear(TablaHash tabla, unsigned cursor,
+                            FuncionVisitanteTabla visita, void *extra){
+  if (cursor < tabla->capacidad)
+    tablahash_escanear_aux(tabla->elems, tabla->capacidad, cursor, cursor, 0, ~0u,
+                           visita, extra);
+  if (tabla->elemsViejos != NULL && cursor < tabla->capacidadVieja)
+    tablahash_escanear_aux(tabla->elemsViejos, tabla->capacidadVieja, cursor, cursor,
+                           0, ~0u, visita, extra);
+  unsigned fin = (tabla->capacidad > tabla->capacidadVieja) ? tabla->capacidad
+                                                            : tabla->capacidadVieja;
+  return (cursor + 1 < fin) ? cursor + 1 : 0;
+}
+#else
+/**
+ * Recorrido por partes. El cursor es un valor del hash mezclado: cada llamada
+ * visita los datos cuyo hash mezclado va desde el cursor hasta el final de su
+ * casilla inicial en el arreglo actual. Como la casilla inicial son los bits
+ * altos del hash mezclado, al redimensionar cada casilla se parte en varias
+ * consecutivas (o varias se juntan en una), y el cursor sigue separando los
+ * datos ya visitados de los que faltan. Es el mismo cursor de SCAN en Redis,
+ * que incrementa los bits al reves porque alli la casilla son los bits bajos.
+ */
+unsigned tablahash_escanear(TablaHash tabla, unsigned cursor,
+                            FuncionVisitanteTabla visita, void *extra){
+  unsigned desplazamiento = 32 - __builtin_ctz(tabla->capacidad);
+  unsigned hasta = cursor | ((1u << desplazamiento) - 1);
+  tablahash_escanear_aux(tabla->elems, tabla->capacidad, cursor >> desplazamiento,
+                         hasta >> desplazamiento, cursor, hasta, visita, extra);
+  if (tabla->elemsViejos != NULL)
+  {
+    desplazamiento = 32 - __builtin_ctz(tabla->capacidadVieja);
+    tablahash_escanear_aux(tabla->elemsViejos, tabla->capacidadVieja,
+                           cursor >> desplazamiento, hasta >> desplazamiento, cursor,
+                           hasta, visita, extra);
+  }
+  return hasta + 1;
+}
+#endif
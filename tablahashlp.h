@@ -0,0 +1,27 @@
+#ifndef __TABLAHASHLP_H__
+#define __TABLAHASHLP_H__
+
+#include "tablahash.h"
+
+/**
+ * Funciones propias de la implementacion con direccionamiento abierto
+ * (tablahashlp.c), ademas de las de tablahash.h.
+ */
+
+/**
+ * Pone un filtro de Bloom por bloques (ver filtrobloom.h) delante de las
+ * busquedas, con bitsPorDato bits por dato, o lo quita si bitsPorDato es 0.
+ * Las busquedas de datos que el filtro descarta no recorren la tabla. El
+ * filtro se mantiene al insertar, se vuelve a armar al redimensionar, y como
+ * no puede quitar datos, tambien se vuelve a armar cuando se elimino la mitad
+ * de los datos para los que fue dimensionado.
+ */
+void tablahash_lp_filtro(TablaHash tabla, unsigned bitsPorDato);
+
+/**
+ * Retorna la fraccion de las busquedas de datos ausentes que el filtro dejo
+ * pasar (falsos positivos) desde que se activo, o 0 si no hubo ninguna.
+ */
+double tablahash_lp_falsos_positivos(TablaHash tabla);
+
+#endif /* __TABLAHASHLP_H__ */
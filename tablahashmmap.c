@@ -0,0 +1,214 @@
+#define _POSIX_C_SOURCE 200809L
+#include "tablahashmmap.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define INDICE(hash, capacidad) \
+  ((unsigned)((hash) * 2654435769u) >> (32 - __builtin_ctz(capacidad)))
+#define SIGUIENTE(idx, capacidad) (((idx) + 1) & ((capacidad) - 1))
+#define MAGIA "TABLAHMM"
+#define VERSION 1
+#define VACIA UINT64_MAX
+#define ALINEACION 8
+
+/**
+ * Formato del archivo: la cabecera, capacidad casillas y tamArena bytes de
+ * arena. La capacidad es una potencia de dos de al menos el doble de los
+ * datos, y cada dato ocupa en la arena tamano bytes alineados a ALINEACION.
+ * Una casilla esta libre si su desplazamiento es VACIA.
+ */
+typedef struct {
+  char magia[8];
+  uint32_t version;
+  uint32_t capacidad;
+  uint64_t numElems;
+  uint64_t tamArena;
+} Cabecera;
+
+typedef struct {
+  uint64_t desplazamiento;
+  uint32_t hash;
+  uint32_t tamano;
+} Casilla;
+
+/**
+ * Estructura principal que representa una imagen abierta.
+ */
+struct _TablaHashMmap {
+  void *mapa;
+  size_t tamMapa;
+  const Cabecera *cabecera;
+  const Casilla *casillas;
+  const char *arena;
+  FuncionComparadora comp;
+  FuncionHash hash;
+};
+
+/**
+ * Arreglo dinamico con los datos de la tabla a guardar.
+ */
+typedef struct {
+  void **datos;
+  size_t num;
+  size_t capacidad;
+} Recoleccion;
+
+static void recolectar(void *dato, void *extra) {
+  Recoleccion *recoleccion = extra;
+  if (recoleccion->num == recoleccion->capacidad) {
+    recoleccion->capacidad = recoleccion->capacidad ? recoleccion->capacidad * 2 : 64;
+    recoleccion->datos = realloc(recoleccion->datos,
+                                 sizeof(void *) * recoleccion->capacidad);
+    assert(recoleccion->datos != NULL);
+  }
+  recoleccion->datos[recoleccion->num++] = dato;
+}
+
+/**
+ * Guarda en el archivo ruta los datos de la tabla.
+ */
+int tablahashmmap_guardar(TablaHash tabla, const char *ruta, FuncionTamano tam,
+                          FuncionHash hash) {
+  Recoleccion recoleccion = {NULL, 0, 0};
+  tablahash_recorrer(tabla, recolectar, &recoleccion);
+
+  Cabecera cabecera;
+  memcpy(cabecera.magia, MAGIA, sizeof(cabecera.magia));
+  cabecera.version = VERSION;
+  cabecera.capacidad = 2;
+  while (cabecera.capacidad < 2 * recoleccion.num)
+    cabecera.capacidad *= 2;
+  cabecera.numElems = recoleccion.num;
+  cabecera.tamArena = 0;
+
+  // Ubicamos cada dato en las casillas y le asignamos su lugar en la arena.
+  Casilla *casillas = malloc(sizeof(Casilla) * cabecera.capacidad);
+  assert(casillas != NULL);
+  for (unsigned idx = 0; idx < cabecera.capacidad; ++idx)
+    casillas[idx].desplazamiento = VACIA;
+  for (size_t i = 0; i < recoleccion.num; ++i) {
+    unsigned h = hash(recoleccion.datos[i]);
+    size_t tamano = tam(recoleccion.datos[i]);
+    assert(tamano <= UINT32_MAX);
+    unsigned idx = INDICE(h, cabecera.capacidad);
+    while (casillas[idx].desplazamiento != VACIA)
+      idx = SIGUIENTE(idx, cabecera.capacidad);
+    casillas[idx].desplazamiento = cabecera.tamArena;
+    casillas[idx].hash = h;
+    casillas[idx].tamano = tamano;
+    cabecera.tamArena += (tamano + ALINEACION - 1) / ALINEACION * ALINEACION;
+  }
+
+  // Escribimos la cabecera, las casillas y la arena, en el orden de los datos.
+  FILE *archivo = fopen(ruta, "wb");
+  int error = (archivo == NULL);
+  if (!error)
+    error = fwrite(&cabecera, sizeof(Cabecera), 1, archivo) != 1 ||
+            fwrite(casillas, sizeof(Casilla), cabecera.capacidad, archivo) !=
+                cabecera.capacidad;
+  static const char relleno[ALINEACION] = {0};
+  for (size_t i = 0; !error && i < recoleccion.num; ++i) {
+    size_t tamano = tam(recoleccion.datos[i]);
+    size_t sobrante = (ALINEACION - tamano % ALINEACION) % ALINEACION;
+    error = fwrite(recoleccion.datos[i], 1, tamano, archivo) != tamano ||
+            fwrite(relleno, 1, sobrante, archivo) != sobrante;
+  }
+  if (archivo != NULL && fclose(archivo) != 0)
+    error = 1;
+
+  free(casillas);
+  free(recoleccion.datos);
+  return error ? -1 : 0;
+}
+
+/**
+ * Abre la imagen guardada en el archivo ruta. Solo se valida la cabecera y el
+ * tamano del archivo, sin leer las casillas ni la arena: las casillas se
+ * validan al buscar.
+ */
+TablaHashMmap tablahashmmap_abrir(const char *ruta, FuncionComparadora comp,
+                                  FuncionHash hash) {
+  int fd = open(ruta, O_RDONLY);
+  if (fd == -1)
+    return NULL;
+  struct stat info;
+  if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(Cabecera)) {
+    close(fd);
+    return NULL;
+  }
+  void *mapa = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  // El mapeo sigue siendo valido despues de cerrar el archivo.
+  close(fd);
+  if (mapa == MAP_FAILED)
+    return NULL;
+
+  const Cabecera *cabecera = mapa;
+  uint32_t capacidad = cabecera->capacidad;
+  if (memcmp(cabecera->magia, MAGIA, sizeof(cabecera->magia)) != 0 ||
+      cabecera->version != VERSION || capacidad < 2 ||
+      (capacidad & (capacidad - 1)) != 0 ||
+      cabecera->tamArena > (uint64_t)info.st_size ||
+      (uint64_t)info.st_size != sizeof(Cabecera) +
+                                    (uint64_t)capacidad * sizeof(Casilla) +
+                                    cabecera->tamArena) {
+    munmap(mapa, info.st_size);
+    return NULL;
+  }
+
+  TablaHashMmap tabla = malloc(sizeof(struct _TablaHashMmap));
+  assert(tabla != NULL);
+  tabla->mapa = mapa;
+  tabla->tamMapa = info.st_size;
+  tabla->cabecera = cabecera;
+  tabla->casillas = (const Casilla *)(cabecera + 1);
+  tabla->arena = (const char *)(tabla->casillas + capacidad);
+  tabla->comp = comp;
+  tabla->hash = hash;
+  return tabla;
+}
+
+/**
+ * Cierra la imagen.
+ */
+void tablahashmmap_cerrar(TablaHashMmap tabla) {
+  munmap(tabla->mapa, tabla->tamMapa);
+  free(tabla);
+}
+
+/**
+ * Retorna el numero de elementos de la imagen.
+ */
+int tablahashmmap_nelems(TablaHashMmap tabla) {
+  return tabla->cabecera->numElems;
+}
+
+/**
+ * Retorna un puntero al dato de la imagen que coincida con el dato dado, o
+ * NULL si no se encuentra. Una imagen bien formada tiene al menos el doble de
+ * casillas que datos, asi que el sondeo termina en una casilla libre; como el
+ * archivo puede estar corrupto, igual se corta despues de mirar todas las
+ * casillas, y se saltean las casillas cuyo dato no cae dentro de la arena.
+ */
+const void *tablahashmmap_buscar(TablaHashMmap tabla, void *dato) {
+  unsigned hash = tabla->hash(dato);
+  uint32_t capacidad = tabla->cabecera->capacidad;
+  uint64_t tamArena = tabla->cabecera->tamArena;
+  unsigned idx = INDICE(hash, capacidad);
+  for (uint32_t i = 0; i < capacidad && tabla->casillas[idx].desplazamiento != VACIA;
+       ++i, idx = SIGUIENTE(idx, capacidad)) {
+    const Casilla *casilla = &tabla->casillas[idx];
+    if (casilla->hash != hash || casilla->desplazamiento > tamArena ||
+        casilla->tamano > tamArena - casilla->desplazamiento)
+      continue;
+    void *guardado = (void *)(tabla->arena + casilla->desplazamiento);
+    if (tabla->comp(guardado, dato) == 0)
+      return guardado;
+  }
+  return NULL;
+}
@@ -0,0 +1,52 @@
+#ifndef __TABLAHASHMMAP_H__
+#define __TABLAHASHMMAP_H__
+
+#include "tablahash.h"
+#include <stddef.h>
+
+/**
+ * Imagen de solo lectura de una tabla hash, guardada en un archivo con
+ * tablahashmmap_guardar y abierta con mmap. El archivo no contiene punteros:
+ * tiene un arreglo de casillas (desplazamiento, tamano y hash de cada dato) y
+ * una arena con los bytes de los datos, asi que se puede mapear en cualquier
+ * direccion. Abrirlo no lee los datos: las busquedas trabajan directamente
+ * sobre las paginas mapeadas, y el sistema las carga a medida que se usan.
+ * El formato depende del orden de bytes de la maquina que lo escribio.
+ */
+typedef struct _TablaHashMmap *TablaHashMmap;
+
+/**
+ * Guarda en el archivo ruta los datos de la tabla. De cada dato se copian
+ * tam(dato) bytes, asi que los datos no deben contener punteros. hash debe
+ * ser la funcion hash de la tabla (o cualquiera que se vaya a usar luego con
+ * tablahashmmap_abrir). Retorna 0 si pudo escribir el archivo o -1 si no.
+ */
+int tablahashmmap_guardar(TablaHash tabla, const char *ruta, FuncionTamano tam,
+                          FuncionHash hash);
+
+/**
+ * Abre la imagen guardada en el archivo ruta, en tiempo constante. comp y
+ * hash se usan en las busquedas; hash debe ser la misma funcion con la que se
+ * guardo. Retorna NULL si el archivo no existe o no es una imagen valida.
+ */
+TablaHashMmap tablahashmmap_abrir(const char *ruta, FuncionComparadora comp,
+                                  FuncionHash hash);
+
+/**
+ * Cierra la imagen. Los punteros retornados por tablahashmmap_buscar dejan de
+ * ser validos.
+ */
+void tablahashmmap_cerrar(TablaHashMmap tabla);
+
+/**
+ * Retorna el numero de elementos de la imagen.
+ */
+int tablahashmmap_nelems(TablaHashMmap tabla);
+
+/**
+ * Retorna un puntero (de solo lectura) al dato de la imagen que coincida con
+ * el dato dado, o NULL si no se encuentra.
+ */
+const void *tablahashmmap_buscar(TablaHashMmap tabla, void *dato);
+
+#endif /* __TABLAHASHMMAP_H__ */
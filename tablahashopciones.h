@@ -0,0 +1,73 @@
+#ifndef __TABLAHASHOPCIONES_H__
+#define __TABLAHASHOPCIONES_H__
+
+#include "tablahash.h"
+
+/**
+ * Calculos sobre TablaHashOpciones que comparten las implementaciones de la
+ * tabla hash.
+ */
+
+/**
+ * Retorna las opciones con los campos en 0 reemplazados por los valores
+ * predeterminados (cargaPredeterminada es el factor de carga propio de la
+ * implementacion). Una carga maxima por encima de cargaTope se baja a
+ * cargaTope, la mayor que admite la implementacion (0 si no tiene tope).
+ */
+static inline TablaHashOpciones
+tablahash_opciones_completar(const TablaHashOpciones *opciones,
+                             float cargaPredeterminada, float cargaTope) {
+  TablaHashOpciones completas = {0};
+  if (opciones != NULL)
+    completas = *opciones;
+  if (completas.cargaMaxima <= 0)
+    completas.cargaMaxima = cargaPredeterminada;
+  if (cargaTope > 0 && completas.cargaMaxima > cargaTope)
+    completas.cargaMaxima = cargaTope;
+  if (completas.crecimiento <= 1)
+    completas.crecimiento = 2;
+  // Sin histeresis, la tabla creceria y se achicaria con cada dato.
+  if (completas.cargaMinima >= completas.cargaMaxima / 2)
+    completas.cargaMinima = completas.cargaMaxima / 2;
+  return completas;
+}
+
+/**
+ * Retorna la capacidad que sigue a la dada al crecer (al menos una mas).
+ */
+static inline unsigned
+tablahash_capacidad_crecida(const TablaHashOpciones *opciones,
+                            unsigned capacidad) {
+  unsigned crecida = capacidad * opciones->crecimiento + 0.5f;
+  return (crecida > capacidad) ? crecida : capacidad + 1;
+}
+
+/**
+ * Retorna la menor capacidad en la que entran n datos sin superar la carga
+ * maxima.
+ */
+static inline unsigned
+tablahash_capacidad_para(const TablaHashOpciones *opciones, unsigned n) {
+  return (unsigned)(n / opciones->cargaMaxima) + 1;
+}
+
+/**
+ * Retorna la capacidad a la que hay que achicar una tabla de la capacidad
+ * dada con numElems datos, o la misma capacidad si no hay que achicarla. La
+ * nueva capacidad deja la carga a mitad de camino entre la minima y la
+ * maxima, para no volver a redimensionar enseguida.
+ */
+static inline unsigned
+tablahash_capacidad_achicada(const TablaHashOpciones *opciones,
+                             unsigned numElems, unsigned capacidad) {
+  if (opciones->cargaMinima <= 0 || capacidad <= opciones->capacidadMinima ||
+      (float)numElems / capacidad >= opciones->cargaMinima)
+    return capacidad;
+  float cargaMedia = (opciones->cargaMinima + opciones->cargaMaxima) / 2;
+  unsigned achicada = (unsigned)(numElems / cargaMedia) + 1;
+  if (achicada < opciones->capacidadMinima)
+    achicada = opciones->capacidadMinima;
+  return (achicada < capacidad) ? achicada : capacidad;
+}
+
+#endif /* __TABLAHASHOPCIONES_H__ */
@@ -1,8 +1,13 @@
 #include "tablahash.h"
+#include "tablahashcontadores.h"
+#include "tablahashopciones.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #define FACTOR_CARGA(numElms, casillas) ((float)(numElms)/(casillas))
 #define LIMITE 0.7
+// Mayor carga maxima admitida: sin colisiones la carga nunca pasa de 1.
+#define CARGA_TOPE 1
 //IMPLEMENTACION DE TABLA HASH SIN MANEJO DE COLISIONES.//
 
 /**
@@ -14,35 +19,53 @@ typedef struct {
 
 /**
  * Estructura principal que representa la tabla hash.
+ * Durante una redimension incremental, elemsViejos guarda el arreglo anterior
+ * (de capacidadVieja casillas), del cual ya se migraron las primeras
+ * migradas casillas. Fuera de una redimension, elemsViejos es NULL.
  */
 struct _TablaHash {
   CasillaHash *elems;
   unsigned numElems;
   unsigned capacidad;
+  CasillaHash *elemsViejos;
+  unsigned capacidadVieja;
+  unsigned migradas;
+  unsigned pasos;
   FuncionCopiadora copia;
   FuncionComparadora comp;
   FuncionDestructora destr;
   FuncionHash hash;
+  TablaHashOpciones opciones;
+  CONTADORES_CAMPO
 };
 
 /**
- * Crea una nueva tabla hash vacia, con la capacidad dada.
+ * Crea una nueva tabla hash vacia, con la capacidad y las opciones dadas.
  */
-TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
-                          FuncionComparadora comp, FuncionDestructora destr,
-                          FuncionHash hash) {
+TablaHash tablahash_crear_con_opciones(unsigned capacidad, FuncionCopiadora copia,
+                                       FuncionComparadora comp,
+                                       FuncionDestructora destr, FuncionHash hash,
+                                       const TablaHashOpciones *opciones) {
 
   // Pedimos memoria para la estructura principal y las casillas.
   TablaHash tabla = malloc(sizeof(struct _TablaHash));
   assert(tabla != NULL);
+  tabla->opciones = tablahash_opciones_completar(opciones, LIMITE, CARGA_TOPE);
+  if (capacidad < tabla->opciones.capacidadMinima)
+    capacidad = tabla->opciones.capacidadMinima;
   tabla->elems = malloc(sizeof(CasillaHash) * capacidad);
   assert(tabla->elems != NULL);
   tabla->numElems = 0;
   tabla->capacidad = capacidad;
+  tabla->elemsViejos = NULL;
+  tabla->capacidadVieja = 0;
+  tabla->migradas = 0;
+  tabla->pasos = 0;
   tabla->copia = copia;
   tabla->comp = comp;
   tabla->destr = destr;
   tabla->hash = hash;
+  CONTADORES_INICIAR(tabla);
 
   // Inicializamos las casillas con datos nulos.
   for (unsigned idx = 0; idx < capacidad; ++idx) {
@@ -52,6 +75,15 @@ TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
   return tabla;
 }
 
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad dada.
+ */
+TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
+                          FuncionComparadora comp, FuncionDestructora destr,
+                          FuncionHash hash) {
+  return tablahash_crear_con_opciones(capacidad, copia, comp, destr, hash, NULL);
+}
+
 /**
  * Retorna el numero de elementos de la tabla.
  */
@@ -72,27 +104,147 @@ void tablahash_destruir(TablaHash tabla) {
     if (tabla->elems[idx].dato != NULL)
       tabla->destr(tabla->elems[idx].dato);
 
+  // Destruir los datos que no se llegaron a migrar.
+  if (tabla->elemsViejos != NULL) {
+    for (unsigned idx = tabla->migradas; idx < tabla->capacidadVieja; ++idx)
+      if (tabla->elemsViejos[idx].dato != NULL)
+        tabla->destr(tabla->elemsViejos[idx].dato);
+    free(tabla->elemsViejos);
+  }
+
   // Liberar el arreglo de casillas y la tabla.
   free(tabla->elems);
   free(tabla);
   return;
 }
 
+/**
+ * Migra a lo sumo n casillas del arreglo anterior al nuevo, sin copiar los
+ * datos. Como en la redimension completa, si la casilla destino ya esta ocupada
+ * por otro dato, el dato migrado se descarta.
+ * Cuando termina de migrar, libera el arreglo anterior.
+ */
+static void tablahash_migrar(TablaHash tabla, unsigned n) {
+  if (tabla->elemsViejos == NULL)
+    return;
+  RELOJ_INICIAR(inicio);
+  for (; n > 0 && tabla->migradas < tabla->capacidadVieja; n--, tabla->migradas++) {
+    void *dato = tabla->elemsViejos[tabla->migradas].dato;
+    if (dato == NULL)
+      continue;
+    tabla->elemsViejos[tabla->migradas].dato = NULL;
+    unsigned idx = tabla->hash(dato) % tabla->capacidad;
+    if (tabla->elems[idx].dato == NULL)
+      tabla->elems[idx].dato = dato;
+    else {
+      tabla->destr(dato);
+      tabla->numElems--;
+    }
+  }
+  if (tabla->migradas == tabla->capacidadVieja) {
+    free(tabla->elemsViejos);
+    tabla->elemsViejos = NULL;
+    tabla->capacidadVieja = 0;
+    tabla->migradas = 0;
+  }
+  RELOJ_DETENER(tabla, inicio);
+}
+
+/**
+ * Reemplaza el arreglo de casillas por uno de la capacidad dada y deja el
+ * anterior pendiente de migrar.
+ */
+static void tablahash_iniciar_migracion(TablaHash tabla, unsigned capacidad) {
+  assert(tabla->elemsViejos == NULL);
+  RELOJ_INICIAR(inicio);
+  REGISTRAR_REDIMENSION(tabla);
+  tabla->elemsViejos = tabla->elems;
+  tabla->capacidadVieja = tabla->capacidad;
+  tabla->migradas = 0;
+  tabla->capacidad = capacidad;
+  // En cero, para no recorrer el arreglo nuevo entero al crearlo.
+  tabla->elems = calloc(tabla->capacidad, sizeof(CasillaHash));
+  assert(tabla->elems);
+  RELOJ_DETENER(tabla, inicio);
+}
+
+/**
+ * Cambia la capacidad de la tabla, despues de completar la migracion pendiente
+ * si la hay. Con la redimension incremental activa, la migracion al nuevo
+ * arreglo queda pendiente.
+ */
+static void tablahash_redimensionar_a(TablaHash tabla, unsigned capacidad) {
+  tablahash_migrar(tabla, tabla->capacidadVieja);
+  tablahash_iniciar_migracion(tabla, capacidad);
+  if (tabla->pasos == 0)
+    tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Agranda la tabla de una vez para que entren n datos sin redimensionar.
+ */
+void tablahash_reservar(TablaHash tabla, unsigned n) {
+  unsigned capacidad = tablahash_capacidad_para(&tabla->opciones, n);
+  if (capacidad <= tabla->capacidad)
+    return;
+  tablahash_redimensionar_a(tabla, capacidad);
+  tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Activa la redimension incremental, migrando a lo sumo pasos casillas por
+ * operacion.
+ */
+void tablahash_redimension_incremental(TablaHash tabla, unsigned pasos) {
+  tabla->pasos = pasos;
+  if (pasos == 0)
+    tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Retorna la casilla del arreglo anterior que contiene al dato, o NULL si no hay
+ * redimension en curso o el dato no quedo alli.
+ */
+static CasillaHash *tablahash_casilla_vieja(TablaHash tabla, void *dato,
+                                            unsigned hash) {
+  if (tabla->elemsViejos == NULL)
+    return NULL;
+  CasillaHash *casilla = &tabla->elemsViejos[hash % tabla->capacidadVieja];
+  if (casilla->dato != NULL && tabla->comp(casilla->dato, dato) == 0)
+    return casilla;
+  return NULL;
+}
+
 /**
  * Inserta un dato en la tabla, o lo reemplaza si ya se encontraba.
  * IMPORTANTE: La implementacion no maneja colisiones.
  */
-void tablahash_insertar(TablaHash tabla, void *dato) {
+void tablahash_insertar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  tablahash_migrar(tabla, tabla->pasos);
 
-  // Calculamos la posicion del dato dado, de acuerdo a la funcion hash.
-  unsigned idx = tabla->hash(dato) % tabla->capacidad;
+  // Calculamos la posicion del dato dado, de acuerdo a su hash.
+  unsigned idx = hash % tabla->capacidad;
+
+  // Si el dato todavia esta en el arreglo anterior, lo reemplazamos en el nuevo.
+  CasillaHash *vieja = tablahash_casilla_vieja(tabla, dato, hash);
+  if (vieja != NULL) {
+    tabla->destr(vieja->dato);
+    // Si la casilla nueva esta ocupada por otro dato, se lo reemplaza donde esta.
+    if (tabla->elems[idx].dato != NULL) {
+      vieja->dato = tabla->copia(dato);
+      return;
+    }
+    vieja->dato = NULL;
+    tabla->numElems--;
+  }
 
   // Insertar el dato si la casilla estaba libre.
   if (tabla->elems[idx].dato == NULL) {
     tabla->elems[idx].dato = tabla->copia(dato);
     tabla->numElems++;
-    if(FACTOR_CARGA(tabla->numElems,tabla->capacidad) >= LIMITE) 
-      tablahash_redimensionar(tabla);
+    if(FACTOR_CARGA(tabla->numElems,tabla->capacidad) >= tabla->opciones.cargaMaxima)
+      tablahash_redimensionar_a(tabla, tablahash_capacidad_crecida(&tabla->opciones,
+                                                                   tabla->capacidad));
     return;
   }
   // Sobrescribir el dato si el mismo ya se encontraba en la tabla.
@@ -106,70 +258,201 @@ void tablahash_insertar(TablaHash tabla, void *dato) {
     return;
   }
 }
+void tablahash_insertar(TablaHash tabla, void *dato) {
+  tablahash_insertar_hash(tabla, dato, tabla->hash(dato));
+}
 
 /**
  * Retorna el dato de la tabla que coincida con el dato dado, o NULL si el dato
  * buscado no se encuentra en la tabla.
  */
-void *tablahash_buscar(TablaHash tabla, void *dato) {
+void *tablahash_buscar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  tablahash_migrar(tabla, tabla->pasos);
 
-  // Calculamos la posicion del dato dado, de acuerdo a la funcion hash.
-  unsigned idx = tabla->hash(dato) % tabla->capacidad;
+  // Calculamos la posicion del dato dado, de acuerdo a su hash.
+  unsigned idx = hash % tabla->capacidad;
 
-  // Retornar NULL si la casilla estaba vacia.
-  if (tabla->elems[idx].dato == NULL)
-    return NULL;
   // Retornar el dato de la casilla si hay concidencia.
-  else if (tabla->comp(tabla->elems[idx].dato, dato) == 0)
+  if (tabla->elems[idx].dato != NULL &&
+      tabla->comp(tabla->elems[idx].dato, dato) == 0) {
+    REGISTRAR_BUSQUEDA(tabla, 1, 1);
     return tabla->elems[idx].dato;
-  // Retornar NULL en otro caso.
-  else
-    return NULL;
+  }
+  // Mientras dure la migracion, el dato puede seguir en el arreglo anterior.
+  CasillaHash *vieja = tablahash_casilla_vieja(tabla, dato, hash);
+  REGISTRAR_BUSQUEDA(tabla, (tabla->elemsViejos != NULL) ? 2 : 1, vieja != NULL);
+  return (vieja != NULL) ? vieja->dato : NULL;
+}
+void *tablahash_buscar(TablaHash tabla, void *dato) {
+  return tablahash_buscar_hash(tabla, dato, tabla->hash(dato));
+}
+
+/**
+ * Busca n datos de una vez.
+ * En esta implementacion no se adelanta la carga de las casillas.
+ */
+void tablahash_buscar_lote(TablaHash tabla, void **claves, size_t n,
+                           void **resultados) {
+  for (size_t i = 0; i < n; i++)
+    resultados[i] = tablahash_buscar(tabla, claves[i]);
+}
+
+/**
+ * Inserta n datos de una vez.
+ */
+void tablahash_insertar_lote(TablaHash tabla, void **datos, size_t n) {
+  for (size_t i = 0; i < n; i++)
+    tablahash_insertar(tabla, datos[i]);
 }
 
 /**
  * Elimina el dato de la tabla que coincida con el dato dado.
  */
-void tablahash_eliminar(TablaHash tabla, void *dato) {
+void tablahash_eliminar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  tablahash_migrar(tabla, tabla->pasos);
 
-  // Calculamos la posicion del dato dado, de acuerdo a la funcion hash.
-  unsigned idx = tabla->hash(dato) % tabla->capacidad;
+  // Calculamos la posicion del dato dado, de acuerdo a su hash.
+  unsigned idx = hash % tabla->capacidad;
 
-  // Retornar si la casilla estaba vacia.
-  if (tabla->elems[idx].dato == NULL)
-    return;
   // Vaciar la casilla si hay coincidencia.
-  else if (tabla->comp(tabla->elems[idx].dato, dato) == 0) {
+  if (tabla->elems[idx].dato != NULL &&
+      tabla->comp(tabla->elems[idx].dato, dato) == 0) {
     tabla->numElems--;
     tabla->destr(tabla->elems[idx].dato);
     tabla->elems[idx].dato = NULL;
-    return;
   }
+  // Si no, puede estar en el arreglo anterior.
+  else {
+    CasillaHash *vieja = tablahash_casilla_vieja(tabla, dato, hash);
+    if (vieja == NULL)
+      return;
+    tabla->numElems--;
+    tabla->destr(vieja->dato);
+    vieja->dato = NULL;
+  }
+
+  // Si quedo por debajo de la carga minima, achicamos la tabla. Como al
+  // crecer, los datos que colisionen en la nueva capacidad se descartan.
+  unsigned capacidad = tablahash_capacidad_achicada(&tabla->opciones,
+                                                    tabla->numElems, tabla->capacidad);
+  if (capacidad < tabla->capacidad)
+    tablahash_redimensionar_a(tabla, capacidad);
+}
+void tablahash_eliminar(TablaHash tabla, void *dato) {
+  tablahash_eliminar_hash(tabla, dato, tabla->hash(dato));
 }
 
 /**
- * Duplica la capacidad de la tabla y reposiciona todos los elementos de acuerdo a la nueva
- * posicion que le asigne la funcion de hash.
+ * Multiplica la capacidad de la tabla por el factor de crecimiento y reposiciona todos los
+ * elementos de acuerdo a la nueva posicion que le asigne la funcion de hash.
  */
 void tablahash_redimensionar(TablaHash tabla){
-  //Guardo todos los datos anteriores.
-  unsigned cap_anterior=tabla->capacidad;
-  CasillaHash* elms_anteriores=tabla->elems;
-  unsigned num_elms_anterior=tabla->numElems;
-  //Redimensiono la tabla.
-  tabla->capacidad*=2;
-  tabla->elems=malloc(sizeof(CasillaHash)*tabla->capacidad);
-  assert(tabla->elems);
-  tabla->numElems=0;
-  for (unsigned i = 0; i < tabla->capacidad; i++)
-    tabla->elems[i].dato=NULL;
-  for (unsigned i = 0; i < cap_anterior; i++)
-  {
-    if (elms_anteriores[i].dato != NULL)
-    {
-      tablahash_insertar(tabla,elms_anteriores[i].dato);
-      tabla->destr(elms_anteriores[i].dato);
-    }
+  //Reubico todos los elementos en un arreglo de mayor capacidad.
+  tablahash_redimensionar_a(tabla, tablahash_capacidad_crecida(&tabla->opciones,
+                                                               tabla->capacidad));
+  tablahash_migrar(tabla, tabla->capacidadVieja);
+}
+
+/**
+ * Completa estadisticas con el estado actual de la tabla y, si esta
+ * instrumentada, con los contadores acumulados desde su creacion.
+ * Como cada dato esta siempre en su casilla inicial, una busqueda exitosa
+ * sondea una sola casilla (dos mientras dura una redimension incremental).
+ */
+void tablahash_estadisticas(TablaHash tabla, TablaHashEstadisticas *estadisticas) {
+  memset(estadisticas, 0, sizeof(TablaHashEstadisticas));
+  estadisticas->numElems = tabla->numElems;
+  estadisticas->capacidad = tabla->capacidad;
+  for (unsigned idx = 0; idx < tabla->capacidad; ++idx)
+    if (tabla->elems[idx].dato != NULL)
+      estadisticas->casillasUsadas++;
+  if (tabla->elemsViejos != NULL)
+    for (unsigned idx = tabla->migradas; idx < tabla->capacidadVieja; ++idx)
+      if (tabla->elemsViejos[idx].dato != NULL)
+        estadisticas->casillasUsadas++;
+  if (tabla->numElems > 0)
+    estadisticas->sondeoMaximo = (tabla->elemsViejos != NULL) ? 2 : 1;
+  contadores_volcar(tabla, estadisticas);
+}
+
+/**
+ * Aplica visita a cada dato de la tabla, incluidos los que todavia no se
+ * migraron del arreglo anterior.
+ */
+void tablahash_recorrer(TablaHash tabla, FuncionVisitanteTabla visita,
+                        void *extra) {
+  for (unsigned idx = 0; idx < tabla->capacidad; ++idx)
+    if (tabla->elems[idx].dato != NULL)
+      visita(tabla->elems[idx].dato, extra);
+  if (tabla->elemsViejos != NULL)
+    for (unsigned idx = tabla->migradas; idx < tabla->capacidadVieja; ++idx)
+      if (tabla->elemsViejos[idx].dato != NULL)
+        visita(tabla->elemsViejos[idx].dato, extra);
+}
+
+/**
+ * Estructura del iterador: recorre las casillas de elems y, al terminarlas,
+ * las del arreglo anterior que quedan por migrar.
+ */
+struct _TablaHashIter {
+  TablaHash tabla;
+  CasillaHash *elems;
+  unsigned capacidad;
+  unsigned idx;
+};
+
+/**
+ * Crea un iterador sobre los datos de la tabla.
+ */
+TablaHashIter tablahash_iter_crear(TablaHash tabla) {
+  TablaHashIter iter = malloc(sizeof(struct _TablaHashIter));
+  assert(iter != NULL);
+  iter->tabla = tabla;
+  iter->elems = tabla->elems;
+  iter->capacidad = tabla->capacidad;
+  iter->idx = 0;
+  return iter;
+}
+
+/**
+ * Retorna el siguiente dato del iterador, o NULL si ya se recorrieron todos.
+ */
+void *tablahash_iter_siguiente(TablaHashIter iter) {
+  for (;;) {
+    for (; iter->idx < iter->capacidad; ++iter->idx)
+      if (iter->elems[iter->idx].dato != NULL)
+        return iter->elems[iter->idx++].dato;
+    // Terminado el arreglo actual, seguimos con el anterior, si lo hay.
+    TablaHash tabla = iter->tabla;
+    if (iter->elems != tabla->elems || tabla->elemsViejos == NULL)
+      return NULL;
+    iter->elems = tabla->elemsViejos;
+    iter->capacidad = tabla->capacidadVieja;
+    iter->idx = tabla->migradas;
   }
-  free(elms_anteriores);
-}
\ No newline at end of file
+}
+
+/**
+ * Destruye el iterador.
+ */
+void tablahash_iter_destruir(TablaHashIter iter) {
+  free(iter);
+}
+
+/**
+ * Recorrido por partes. Como la casilla de cada dato es su hash modulo la
+ * capacidad, las casillas no conservan ningun orden al redimensionar, asi que
+ * el cursor es simplemente la casilla a visitar (en ambos arreglos mientras
+ * dura una redimension incremental).
+ */
+unsigned tablahash_escanear(TablaHash tabla, unsigned cursor,
+                            FuncionVisitanteTabla visita, void *extra) {
+  if (cursor < tabla->capacidad && tabla->elems[cursor].dato != NULL)
+    visita(tabla->elems[cursor].dato, extra);
+  if (tabla->elemsViejos != NULL && cursor < tabla->capacidadVieja &&
+      tabla->elemsViejos[cursor].dato != NULL)
+    visita(tabla->elemsViejos[cursor].dato, extra);
+  unsigned fin = (tabla->capacidad > tabla->capacidadVieja) ? tabla->capacidad
+                                                            : tabla->capacidadVieja;
+  return (cursor + 1 < fin) ? cursor + 1 : 0;
+}
@@ -0,0 +1,502 @@
+#include "tablahash.h"
+#include "tablahashcontadores.h"
+#include "tablahashopciones.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#define FACTOR_CARGA(numElms, casillas) ((float)(numElms)/(casillas))
+#define LIMITE 0.875
+// Mayor carga maxima admitida: cada sondeo tiene que terminar en un grupo con
+// una casilla libre.
+#define CARGA_TOPE 0.95
+#define TAM_LOTE 16
+//IMPLEMENTACION DE TABLA HASH CON DIRECCIONAMIENTO ABIERTO POR GRUPOS (SIMD).//
+/**
+ * Los datos se guardan en grupos de TAM_GRUPO casillas. Por cada casilla hay
+ * un byte de control en un arreglo aparte:
+ *  - CTRL_VACIO si la casilla esta libre,
+ *  - CTRL_BORRADO si el dato fue eliminado,
+ *  - los 7 bits bajos del hash mezclado (H2) si la casilla esta ocupada.
+ * Un grupo entero se compara de una sola vez con SSE2 (o con un ciclo escalar
+ * si no esta disponible), asi que la mayoria de las busquedas no necesitan
+ * leer los punteros a los datos ni llamar a la funcion comparadora.
+ */
+#define TAM_GRUPO 16
+#define CTRL_VACIO ((int8_t)-128)
+#define CTRL_BORRADO ((int8_t)-2)
+#define H1(mezcla) ((mezcla) >> 7)
+#define H2(mezcla) ((int8_t)((mezcla) & 0x7F))
+// La cantidad de grupos es una potencia de dos: el grupo inicial son los bits
+// bajos de H1.
+#define GRUPO(mezcla, numGrupos) (H1(mezcla) & ((numGrupos) - 1))
+
+/**
+ * Mezcla los bits del hash antes de partirlo en H1 y H2, para que los datos no
+ * se amontonen en unos pocos grupos (ni compartan H2) cuando la funcion de hash
+ * solo varia en los bits altos, o solo en los bajos. La multiplicacion lleva
+ * cada bit hacia los altos y el corrimiento trae los altos a los bajos.
+ */
+static inline unsigned mezclar(unsigned hash) {
+  hash *= 2654435769u;
+  return hash ^ (hash >> 16);
+}
+
+/**
+ * Estructura principal que representa la tabla hash.
+ */
+struct _TablaHash {
+  int8_t *ctrl;
+  void **datos;
+  unsigned numElems;
+  unsigned numBorrados;
+  unsigned numGrupos;
+  FuncionCopiadora copia;
+  FuncionComparadora comp;
+  FuncionDestructora destr;
+  FuncionHash hash;
+  TablaHashOpciones opciones;
+  CONTADORES_CAMPO
+};
+
+/**
+ * Retorna una mascara de bits con las casillas del grupo cuyo byte de control
+ * es igual a h2.
+ */
+static unsigned grupo_coincidencias(const int8_t *ctrl, int8_t h2) {
+#ifdef __SSE2__
+  __m128i grupo = _mm_loadu_si128((const __m128i *)ctrl);
+  return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(grupo, _mm_set1_epi8(h2)));
+#else
+  unsigned mascara = 0;
+  for (unsigned i = 0; i < TAM_GRUPO; ++i)
+    if (ctrl[i] == h2)
+      mascara |= 1u << i;
+  return mascara;
+#endif
+}
+
+/**
+ * Retorna una mascara de bits con las casillas libres del grupo.
+ */
+static unsigned grupo_vacios(const int8_t *ctrl) {
+  return grupo_coincidencias(ctrl, CTRL_VACIO);
+}
+
+/**
+ * Retorna una mascara de bits con las casillas libres o eliminadas del grupo
+ * (las unicas con el bit mas significativo encendido).
+ */
+static unsigned grupo_disponibles(const int8_t *ctrl) {
+#ifdef __SSE2__
+  return (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+  unsigned mascara = 0;
+  for (unsigned i = 0; i < TAM_GRUPO; ++i)
+    if (ctrl[i] < 0)
+      mascara |= 1u << i;
+  return mascara;
+#endif
+}
+
+/**
+ * Retorna la posicion del bit encendido menos significativo de la mascara.
+ */
+static unsigned primer_bit(unsigned mascara) {
+  assert(mascara);
+  return (unsigned)__builtin_ctz(mascara);
+}
+
+/**
+ * Pide memoria para numGrupos grupos vacios.
+ */
+static void tablahash_inicializar_grupos(TablaHash tabla, unsigned numGrupos) {
+  unsigned capacidad = numGrupos * TAM_GRUPO;
+  tabla->ctrl = malloc(sizeof(int8_t) * capacidad);
+  assert(tabla->ctrl);
+  tabla->datos = malloc(sizeof(void *) * capacidad);
+  assert(tabla->datos);
+  memset(tabla->ctrl, CTRL_VACIO, capacidad);
+  tabla->numGrupos = numGrupos;
+  tabla->numElems = 0;
+  tabla->numBorrados = 0;
+}
+
+/**
+ * Retorna la cantidad de grupos necesaria para la capacidad dada: la menor
+ * potencia de dos (al menos uno) que la alcanza.
+ */
+static unsigned tablahash_grupos_para(unsigned capacidad) {
+  unsigned necesarios = (capacidad + TAM_GRUPO - 1) / TAM_GRUPO;
+  unsigned numGrupos = 1;
+  while (numGrupos < necesarios)
+    numGrupos <<= 1;
+  return numGrupos;
+}
+
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad y las opciones dadas.
+ * La capacidad se redondea hacia arriba a TAM_GRUPO por una potencia de dos.
+ */
+TablaHash tablahash_crear_con_opciones(unsigned capacidad, FuncionCopiadora copia,
+                                       FuncionComparadora comp,
+                                       FuncionDestructora destr, FuncionHash hash,
+                                       const TablaHashOpciones *opciones) {
+  TablaHash tabla = malloc(sizeof(struct _TablaHash));
+  assert(tabla);
+  tabla->copia = copia;
+  tabla->comp = comp;
+  tabla->destr = destr;
+  tabla->hash = hash;
+  tabla->opciones = tablahash_opciones_completar(opciones, LIMITE, CARGA_TOPE);
+  CONTADORES_INICIAR(tabla);
+
+  if (capacidad < tabla->opciones.capacidadMinima)
+    capacidad = tabla->opciones.capacidadMinima;
+  tablahash_inicializar_grupos(tabla, tablahash_grupos_para(capacidad));
+  return tabla;
+}
+
+/**
+ * Crea una nueva tabla hash vacia, con la capacidad dada.
+ * La capacidad se redondea hacia arriba a TAM_GRUPO por una potencia de dos.
+ */
+TablaHash tablahash_crear(unsigned capacidad, FuncionCopiadora copia,
+                          FuncionComparadora comp, FuncionDestructora destr,
+                          FuncionHash hash) {
+  return tablahash_crear_con_opciones(capacidad, copia, comp, destr, hash, NULL);
+}
+
+/**
+ * Retorna el numero de elementos de la tabla.
+ */
+int tablahash_nelems(TablaHash tabla) { return tabla->numElems; }
+
+/**
+ * Retorna la capacidad de la tabla.
+ */
+int tablahash_capacidad(TablaHash tabla) {
+  return tabla->numGrupos * TAM_GRUPO;
+}
+
+/**
+ * Destruye la tabla.
+ */
+void tablahash_destruir(TablaHash tabla) {
+  unsigned capacidad = tabla->numGrupos * TAM_GRUPO;
+  for (unsigned idx = 0; idx < capacidad; ++idx)
+    if (tabla->ctrl[idx] >= 0)
+      tabla->destr(tabla->datos[idx]);
+  free(tabla->ctrl);
+  free(tabla->datos);
+  free(tabla);
+}
+
+/**
+ * Retorna la posicion del dato en la tabla, o -1 si no se encuentra.
+ * Si disponible no es NULL, guarda en el la primera casilla libre o eliminada
+ * de la secuencia de sondeo (o -1 si no hay ninguna). Si sondeos no es NULL,
+ * le suma los grupos revisados.
+ */
+static long tablahash_sondear(TablaHash tabla, void *dato, unsigned hash,
+                              long *disponible, unsigned *sondeos) {
+  unsigned mezcla = mezclar(hash);
+  int8_t h2 = H2(mezcla);
+  unsigned grupo = GRUPO(mezcla, tabla->numGrupos);
+  if (disponible != NULL)
+    *disponible = -1;
+
+  for (unsigned i = 0; i < tabla->numGrupos; ++i) {
+    const int8_t *ctrl = &tabla->ctrl[grupo * TAM_GRUPO];
+    CONTAR(sondeos, 1);
+    // Solo se compara con los datos cuyo H2 coincide.
+    for (unsigned m = grupo_coincidencias(ctrl, h2); m != 0; m &= m - 1) {
+      unsigned idx = grupo * TAM_GRUPO + primer_bit(m);
+      if (tabla->comp(tabla->datos[idx], dato) == 0)
+        return idx;
+    }
+    if (disponible != NULL && *disponible == -1) {
+      unsigned libres = grupo_disponibles(ctrl);
+      if (libres != 0)
+        *disponible = grupo * TAM_GRUPO + primer_bit(libres);
+    }
+    // Si el grupo tiene una casilla libre, el dato no puede estar mas adelante.
+    if (grupo_vacios(ctrl) != 0)
+      return -1;
+    grupo = (grupo + 1) & (tabla->numGrupos - 1);
+  }
+  return -1;
+}
+
+/**
+ * Reubica todos los elementos en numGrupos grupos nuevos, de acuerdo a la
+ * posicion que les asigne la funcion de hash. Las casillas eliminadas se
+ * descartan.
+ */
+static void tablahash_reagrupar(TablaHash tabla, unsigned numGrupos) {
+  RELOJ_INICIAR(inicio);
+  REGISTRAR_REDIMENSION(tabla);
+  //Guardo la informacion de la tabla.
+  int8_t *ctrlAnterior = tabla->ctrl;
+  void **datosAnteriores = tabla->datos;
+  unsigned capacidadAnterior = tabla->numGrupos * TAM_GRUPO;
+
+  tablahash_inicializar_grupos(tabla, numGrupos);
+  //Reubico los elementos anteriores sin copiarlos.
+  for (unsigned i = 0; i < capacidadAnterior; i++) {
+    if (ctrlAnterior[i] < 0)
+      continue;
+    unsigned mezcla = mezclar(tabla->hash(datosAnteriores[i]));
+    unsigned grupo = GRUPO(mezcla, tabla->numGrupos);
+    unsigned libres;
+    while ((libres = grupo_vacios(&tabla->ctrl[grupo * TAM_GRUPO])) == 0)
+      grupo = (grupo + 1) & (tabla->numGrupos - 1);
+    unsigned idx = grupo * TAM_GRUPO + primer_bit(libres);
+    tabla->ctrl[idx] = H2(mezcla);
+    tabla->datos[idx] = datosAnteriores[i];
+    tabla->numElems++;
+  }
+  free(ctrlAnterior);
+  free(datosAnteriores);
+  RELOJ_DETENER(tabla, inicio);
+}
+
+/**
+ * Agranda la tabla de una vez para que entren n datos sin redimensionar.
+ */
+void tablahash_reservar(TablaHash tabla, unsigned n) {
+  unsigned numGrupos =
+      tablahash_grupos_para(tablahash_capacidad_para(&tabla->opciones, n));
+  if (numGrupos > tabla->numGrupos)
+    tablahash_reagrupar(tabla, numGrupos);
+}
+
+/**
+ * Inserta un dato en la tabla, o lo reemplaza si ya se encontraba.
+ */
+void tablahash_insertar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  unsigned capacidad = tabla->numGrupos * TAM_GRUPO;
+  if (FACTOR_CARGA(tabla->numElems + tabla->numBorrados + 1, capacidad) >
+      tabla->opciones.cargaMaxima)
+    tablahash_redimensionar(tabla);
+
+  long disponible;
+  long idx = tablahash_sondear(tabla, dato, hash, &disponible, NULL);
+
+  // Caso en que el dato ya se encontraba.
+  if (idx != -1) {
+    tabla->destr(tabla->datos[idx]);
+    tabla->datos[idx] = tabla->copia(dato);
+    return;
+  }
+  assert(disponible != -1);
+  if (tabla->ctrl[disponible] == CTRL_BORRADO)
+    tabla->numBorrados--;
+  tabla->ctrl[disponible] = H2(mezclar(hash));
+  tabla->datos[disponible] = tabla->copia(dato);
+  tabla->numElems++;
+}
+void tablahash_insertar(TablaHash tabla, void *dato) {
+  tablahash_insertar_hash(tabla, dato, tabla->hash(dato));
+}
+
+/**
+ * Retorna el dato de la tabla que coincida con el dato dado, o NULL si el dato
+ * buscado no se encuentra en la tabla.
+ */
+void *tablahash_buscar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  unsigned sondeos = 0;
+  long idx = tablahash_sondear(tabla, dato, hash, NULL, &sondeos);
+  REGISTRAR_BUSQUEDA(tabla, sondeos, idx != -1);
+  return (idx != -1) ? tabla->datos[idx] : NULL;
+}
+void *tablahash_buscar(TablaHash tabla, void *dato) {
+  return tablahash_buscar_hash(tabla, dato, tabla->hash(dato));
+}
+
+/**
+ * Calcula los hashes de un lote de a lo sumo TAM_LOTE datos y adelanta la
+ * carga del grupo inicial de cada uno (bytes de control y punteros).
+ */
+static void tablahash_preparar_lote(TablaHash tabla, void **datos, size_t n,
+                                    unsigned *hashes) {
+  for (size_t i = 0; i < n; i++) {
+    hashes[i] = tabla->hash(datos[i]);
+    unsigned grupo = GRUPO(mezclar(hashes[i]), tabla->numGrupos);
+    __builtin_prefetch(&tabla->ctrl[grupo * TAM_GRUPO]);
+    __builtin_prefetch(&tabla->datos[grupo * TAM_GRUPO]);
+  }
+}
+
+/**
+ * Busca n datos de una vez, de a lotes de TAM_LOTE.
+ */
+void tablahash_buscar_lote(TablaHash tabla, void **claves, size_t n,
+                           void **resultados) {
+  unsigned hashes[TAM_LOTE];
+  for (size_t inicio = 0; inicio < n; inicio += TAM_LOTE) {
+    size_t lote = (n - inicio < TAM_LOTE) ? n - inicio : TAM_LOTE;
+    tablahash_preparar_lote(tabla, &claves[inicio], lote, hashes);
+    for (size_t i = 0; i < lote; i++)
+      resultados[inicio + i] = tablahash_buscar_hash(tabla, claves[inicio + i], hashes[i]);
+  }
+}
+
+/**
+ * Inserta n datos de una vez, de a lotes de TAM_LOTE.
+ */
+void tablahash_insertar_lote(TablaHash tabla, void **datos, size_t n) {
+  unsigned hashes[TAM_LOTE];
+  for (size_t inicio = 0; inicio < n; inicio += TAM_LOTE) {
+    size_t lote = (n - inicio < TAM_LOTE) ? n - inicio : TAM_LOTE;
+    tablahash_preparar_lote(tabla, &datos[inicio], lote, hashes);
+    for (size_t i = 0; i < lote; i++)
+      tablahash_insertar_hash(tabla, datos[inicio + i], hashes[i]);
+  }
+}
+
+/**
+ * Elimina el dato de la tabla que coincida con el dato dado.
+ */
+void tablahash_eliminar_hash(TablaHash tabla, void *dato, unsigned hash) {
+  long idx = tablahash_sondear(tabla, dato, hash, NULL, NULL);
+  if (idx == -1)
+    return;
+
+  tabla->destr(tabla->datos[idx]);
+  tabla->numElems--;
+  // Si el grupo todavia tiene casillas libres, ninguna busqueda paso de largo
+  // por el, asi que la casilla puede quedar libre en vez de eliminada.
+  const int8_t *ctrl = &tabla->ctrl[(idx / TAM_GRUPO) * TAM_GRUPO];
+  if (grupo_vacios(ctrl) != 0)
+    tabla->ctrl[idx] = CTRL_VACIO;
+  else {
+    tabla->ctrl[idx] = CTRL_BORRADO;
+    tabla->numBorrados++;
+  }
+
+  // Si quedo por debajo de la carga minima, achicamos la tabla.
+  unsigned numGrupos = tablahash_grupos_para(tablahash_capacidad_achicada(
+      &tabla->opciones, tabla->numElems, tabla->numGrupos * TAM_GRUPO));
+  if (numGrupos < tabla->numGrupos)
+    tablahash_reagrupar(tabla, numGrupos);
+}
+void tablahash_eliminar(TablaHash tabla, void *dato) {
+  tablahash_eliminar_hash(tabla, dato, tabla->hash(dato));
+}
+
+/**
+ * Multiplica la capacidad de la tabla por el factor de crecimiento y reposiciona todos los
+ * elementos de acuerdo a la nueva posicion que le asigne la funcion de hash. Las casillas
+ * eliminadas se descartan.
+ */
+void tablahash_redimensionar(TablaHash tabla) {
+  unsigned numGrupos = tablahash_grupos_para(tablahash_capacidad_crecida(
+      &tabla->opciones, tabla->numGrupos * TAM_GRUPO));
+  tablahash_reagrupar(tabla, (numGrupos > tabla->numGrupos) ? numGrupos
+                                                             : tabla->numGrupos * 2);
+}
+
+/**
+ * En esta implementacion la redimension es siempre completa: el reubicado por
+ * grupos no deja casillas pendientes, asi que pasos se ignora.
+ */
+void tablahash_redimension_incremental(TablaHash tabla, unsigned pasos) {
+  (void)tabla;
+  (void)pasos;
+}
+
+/**
+ * Completa estadisticas con el estado actual de la tabla y, si esta
+ * instrumentada, con los contadores acumulados desde su creacion.
+ * Como la tabla no guarda los hashes completos, para ubicar el grupo inicial
+ * de cada dato se vuelve a llamar a la funcion hash. Un dato esta desbordado
+ * si no quedo en su grupo inicial.
+ */
+void tablahash_estadisticas(TablaHash tabla, TablaHashEstadisticas *estadisticas) {
+  memset(estadisticas, 0, sizeof(TablaHashEstadisticas));
+  estadisticas->numElems = tabla->numElems;
+  estadisticas->capacidad = tabla->numGrupos * TAM_GRUPO;
+  estadisticas->borradas = tabla->numBorrados;
+  for (unsigned idx = 0; idx < estadisticas->capacidad; ++idx) {
+    if (tabla->ctrl[idx] < 0)
+      continue;
+    estadisticas->casillasUsadas++;
+    unsigned grupo = idx / TAM_GRUPO;
+    unsigned inicial =
+        GRUPO(mezclar(tabla->hash(tabla->datos[idx])), tabla->numGrupos);
+    unsigned distancia = (grupo - inicial) & (tabla->numGrupos - 1);
+    if (distancia != 0)
+      estadisticas->desbordados++;
+    if (distancia + 1 > estadisticas->sondeoMaximo)
+      estadisticas->sondeoMaximo = distancia + 1;
+  }
+  contadores_volcar(tabla, estadisticas);
+}
+
+/**
+ * Aplica visita a cada dato de la tabla.
+ */
+void tablahash_recorrer(TablaHash tabla, FuncionVisitanteTabla visita,
+                        void *extra) {
+  unsigned capacidad = tabla->numGrupos * TAM_GRUPO;
+  for (unsigned idx = 0; idx < capacidad; ++idx)
+    if (tabla->ctrl[idx] >= 0)
+      visita(tabla->datos[idx], extra);
+}
+
+/**
+ * Estructura del iterador: la proxima casilla a revisar.
+ */
+struct _TablaHashIter {
+  TablaHash tabla;
+  unsigned idx;
+};
+
+/**
+ * Crea un iterador sobre los datos de la tabla.
+ */
+TablaHashIter tablahash_iter_crear(TablaHash tabla) {
+  TablaHashIter iter = malloc(sizeof(struct _TablaHashIter));
+  assert(iter);
+  iter->tabla = tabla;
+  iter->idx = 0;
+  return iter;
+}
+
+/**
+ * Retorna el siguiente dato del iterador, o NULL si ya se recorrieron todos.
+ */
+void *tablahash_iter_siguiente(TablaHashIter iter) {
+  TablaHash tabla = iter->tabla;
+  unsigned capacidad = tabla->numGrupos * TAM_GRUPO;
+  for (; iter->idx < capacidad; ++iter->idx)
+    if (tabla->ctrl[iter->idx] >= 0)
+      return tabla->datos[iter->idx++];
+  return NULL;
+}
+
+/**
+ * Destruye el iterador.
+ */
+void tablahash_iter_destruir(TablaHashIter iter) {
+  free(iter);
+}
+
+/**
+ * Recorrido por partes. Los datos que desbordan a otro grupo no conservan
+ * ningun orden al redimensionar, asi que el cursor es simplemente el grupo a
+ * visitar.
+ */
+unsigned tablahash_escanear(TablaHash tabla, unsigned cursor,
+                            FuncionVisitanteTabla visita, void *extra) {
+  if (cursor < tabla->numGrupos) {
+    const int8_t *ctrl = &tabla->ctrl[cursor * TAM_GRUPO];
+    for (unsigned m = ~grupo_disponibles(ctrl) & 0xFFFF; m != 0; m &= m - 1)
+      visita(tabla->datos[cursor * TAM_GRUPO + primer_bit(m)], extra);
+  }
+  return (cursor + 1 < tabla->numGrupos) ? cursor + 1 : 0;
+}